@@ -39,16 +39,97 @@
 
 
 
+/*-------------------------------------------------------------------
+Facilities beyond ISO C are only used where they're known to exist;
+everywhere else, the portable stdio path is taken instead.
+  XSLI_ZEROCOPY : File-to-file block copies with "copy_file_range"
+                  and "sendfile", and decoding straight into mapped
+                  files [Linux].
+  XSLI_THREADS  : "-j" worker threads, and the "-o" writer thread,
+                  with POSIX threads [Linux].
+  XSLI_DAEMON   : "-u" server over a Unix domain socket, with worker
+                  threads and memory-mapped ROMs [Linux].
+  XSLI_GATHER   : "-e" frames written whole with "writev" [Linux].
+  XSLI_TRACE    : "-t" timelines, with a monotonic clock, thread-local
+                  buffers and GCC's atomic builtins [Linux].
+  XSLI_METRICS  : "-x" metrics and progress, sampled by a thread of
+                  their own; relies on "XSLI_TRACE" [Linux].
+  XSLI_WATCH    : "--watch" ingest of a directory with inotify, on
+                  "-j" workers; relies on "XSLI_THREADS" [Linux].
+-------------------------------------------------------------------*/
+#if defined(__linux__)
+#define _GNU_SOURCE
+#define XSLI_ZEROCOPY
+#define XSLI_THREADS
+#define XSLI_DAEMON
+#define XSLI_GATHER
+#define XSLI_TRACE
+#define XSLI_METRICS
+#define XSLI_WATCH
+#endif
+
+
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include <math.h>
+
+#ifdef XSLI_ZEROCOPY
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <sys/sendfile.h>
+#include <unistd.h>
+#endif
+
+#ifdef XSLI_THREADS
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
+#ifdef XSLI_GATHER
+#include <errno.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#ifdef XSLI_METRICS
+#include <pthread.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#ifdef XSLI_DAEMON
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#endif
+
+#ifdef XSLI_WATCH
+#include <dirent.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 
 
 #define EXT_SZP ".szp"  /* SLI Zip Partition */
 #define EXT_SZS ".szs"  /* SLI Zip Stream */
+#define EXT_LZ  ".lz"   /* GBA/DS LZ77 */
 
 
 
@@ -125,6 +206,27 @@
 
 
 
+/*-------------------------------------------------------
+"Yaz1" is "Yaz0" under another FourCC, coded the same
+way, found in some GameCube and Wii data.
+-------------------------------------------------------*/
+#define Yaz1 0x59617A31
+
+
+
+/*--------------------------------------------------------------------
+## GBA/DS Titles [incomplete] that use "LZ10"/"LZ11" ##
+[2004] [GBA] The Legend of Zelda: The Minish Cap
+[2005] [NDS] Mario Kart DS
+[2006] [NDS] New Super Mario Bros.
+These have no FourCC, only a leading byte of 0x10 or 0x11 [the type
+the GBA/DS BIOS takes]; the tags below stand for them in listings.
+--------------------------------------------------------------------*/
+#define LZ10 0x4C5A3130
+#define LZ11 0x4C5A3131
+
+
+
 /*--------------------------------------------
 Some N64 ROMS contain data using an SLI header
 prefixed with "GZIP".
@@ -133,6 +235,29 @@ prefixed with "GZIP".
 
 
 
+/*----------------------------------------------------------
+Archive containers commonly found inside decoded SLI data.
+They are only reported when recursively scanning, since any
+nested SLI blocks they hold are found by the scan regardless.
+## Titles [incomplete] that use "RARC" ##
+[2002] [GCN] Super Mario Sunshine
+[2002] [GCN] The Legend of Zelda: The Wind Waker
+## Titles [incomplete] that use "U8" ##
+[2006] [Wii] The Legend of Zelda: Twilight Princess
+----------------------------------------------------------*/
+#define RARC 0x52415243
+#define U8AR 0x55AA382D
+
+
+
+/*------------------------------------------
+Default and maximum depth for recursive scans.
+------------------------------------------*/
+#define DEPTH_DEF 4
+#define DEPTH_MAX 15
+
+
+
 /*-------------------------------------------------
 FILENAME_MAX
  - [20 Character Game Name + 1 NULL Terminator]
@@ -169,1055 +294,10841 @@ static u32 _swap32( u32 data )
 
 
 
-static struct
+/*--------------------------------------------------------------------
+Big-Endian reads from a buffer left in its original byte ordering.
+"xr" is what a Big-Endian offset is exclusive-or'd with to find where
+that byte actually sits in the buffer, as given by "_getSwizzle".
+--------------------------------------------------------------------*/
+static u32 _peek8( const u8 *srcbuf, const u32 position, const u32 xr )
 {
-  u32 toDecode    : 1;
-  u32 useGameName : 1;
-  u32 writeROM    : 1;
-  u32 verbose     : 1;
+  return (u32)srcbuf[position ^ xr];
 }
-options;
 
+static u32 _peek16( const u8 *srcbuf, const u32 position, const u32 xr )
+{
+  if ( xr == 0 )
+  {
+    return (u32)_swap16( *(u16 *)&srcbuf[position] );
+  }
 
+  return ((u32)srcbuf[(position     ) ^ xr] << 8) |
+          (u32)srcbuf[(position + 1U) ^ xr];
+}
 
-static u32 cleanUpOnError( FILE *SLI, FILE *DECODED,
-                           char *dataEntry, char *decodedDest )
+static u32 _peek32( const u8 *srcbuf, const u32 position, const u32 xr )
 {
-  if ( SLI != (FILE *)0 )
+  if ( xr == 0 )
   {
-    fclose( SLI );
-
-    if ( dataEntry != (char *)0 )
-    {
-      remove( dataEntry );
-    }
+    return _swap32( *(u32 *)&srcbuf[position] );
   }
 
-  if ( DECODED != (FILE *)0 )
+  return ((u32)srcbuf[(position     ) ^ xr] << 24) |
+         ((u32)srcbuf[(position + 1U) ^ xr] << 16) |
+         ((u32)srcbuf[(position + 2U) ^ xr] <<  8) |
+          (u32)srcbuf[(position + 3U) ^ xr];
+}
+
+/*------------------------------------------------------
+CRC32 [IEEE 802.3, reflected], as used by ZIP and PNG.
+------------------------------------------------------*/
+static u32 crcTable[256];
+
+static void _initCRC( void )
+{
+  u32 i = 0;
+
+  while ( i < 256U )
   {
-    fclose( DECODED );
+    u32 crc = i;
+    int j   = 0;
 
-    if ( decodedDest != (char *)0 )
+    while ( j < 8 )
     {
-      remove( decodedDest );
+      crc = (crc >> 1) ^ ((crc & 1U) ? 0xEDB88320U : 0);
+      ++j;
     }
+
+    crcTable[i++] = crc;
   }
 
-  if ( dataEntry != (char *)0 )
+  return;
+}
+
+static u32 _crc32( const u8 *srcbuf, const u32 position,
+                   const u32 length, const u32 xr )
+{
+  register u32 crc = 0xFFFFFFFFU;
+  register u32 i   = 0;
+
+  while ( i < length )
   {
-    free( dataEntry );
-    dataEntry = (char *)0;
+    crc = crcTable[(crc ^ srcbuf[(position + i) ^ xr]) & 0xFFU] ^ (crc >> 8);
+    ++i;
   }
 
-  if ( decodedDest != (char *)0 )
+  return crc ^ 0xFFFFFFFFU;
+}
+
+static void _unswizzle( u8 *dst, const u8 *srcbuf, const u32 position,
+                        const u32 length, const u32 xr )
+{
+  register u32 i = 0;
+
+  while ( i < length )
   {
-    free( decodedDest );
-    decodedDest = (char *)0;
+    dst[i] = srcbuf[(position + i) ^ xr];
+    ++i;
   }
 
-  return 0;
+  return;
 }
 
 
 
-static void decbuf( const u8 *srcbuf, u8 **dst, const u32 position,
-                    const u32 magic, const u32 sizeDecoded )
+static struct
 {
-  u8 *dest;
-  u8 *previous;
-  u32 masks = 0;
-  u32 flags = 0;
-  /*--------------------------------------------------------------------
-  Position for Polymorphic variables.
-  For MIO0/SMSR00, a half-word contains length-displacement information.
-  For Yay0/Yaz0, a half-word contains the former, however, a nibble
-  with a value of 0 serves as a flag to utilize a byte from "defs" for
-  supplemental length values.
-  --------------------------------------------------------------------*/
-  u32 poly  = 0;
-  /*---------------------------------------------------------------------
-  Position for Definitive variables.
-  For MIO0/SMSR00, this is simply for literal byte copies.
-  For Yay0/Yaz0, it is either the former, or a supplementary length byte.
-  With Yay0, "defs" is within the designated partition.
-  With Yaz0, "defs" represents the entirety of the encoded block.
-  ---------------------------------------------------------------------*/
-  u32 defs  = 0;
-  u32 displacement;
-  i32 operations;
+  u32 toDecode    : 1;
+  u32 useGameName : 1;
+  u32 writeROM    : 1;
+  u32 verbose     : 1;
+  u32 maxDepth    : 4;
+  u32 listMode    : 2;
+  u32 checksum    : 1;
+  u32 emitMode    : 2;
+  u32 verify      : 1;
+  u32 showRegions : 1;
+  u32 transcode   : 2;
+  u32 unpack      : 1;
+  u32 diff        : 1;
+  u32 watch       : 1;
+  u32 fixBoot     : 1;
+  u32 carve       : 1;
+}
+options;
 
-  if ( (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU) )
-  {
-    return;
-  }
+/*-----------------------------------------------
+Where "--unpack" writes to, if anywhere but the
+files' own directories; "-" for stdout.
+-----------------------------------------------*/
+static const char *unpackDest = (const char *)0;
 
-  if ( (*dst = (u8 *)calloc( sizeDecoded, sizeof(u8) )) == (u8 *)0 )
-  {
-    return;
-  }
-  
-  dest = *dst + sizeDecoded;
 
-  if ( magic != Yaz )
-  {
-    if ( magic != SMSR )
-    {
-      poly = _swap32( *(u32 *)&srcbuf[position + 0x08U] );
-      defs = _swap32( *(u32 *)&srcbuf[position + 0x0CU] );
 
-      if ( (poly == 0) || (defs < poly) )
-      {
-        return;
-      }
+/*-------------------------------------------------------
+Listing formats for "-l", which writes no files at all.
+-------------------------------------------------------*/
+enum
+{
+  LIST_TEXT = 1,
+  LIST_CSV  = 2,
+  LIST_JSON = 3
+};
 
-      poly += position;
-      defs += position;
-      flags = position + 0x10U;
-    }
-    else
-    {
-      defs = _swap32( *(u32 *)&srcbuf[position + 0x1CU] );
 
-      if ( defs == 0 )
-      {
-        return;
-      }
 
-      defs += position + 0x20U;
-      poly  = position + 0x20U;
-    }
-  }
-  else
-  {
-    if (    (_swap32( *(u32 *)&srcbuf[position + 0x08U] ) != 0)
-         || (_swap32( *(u32 *)&srcbuf[position + 0x0CU] ) != 0) )
-    {
-      return;
-    }
+/*-------------------------------------------------------------
+Payloads framed on the standard output for "-e", which likewise
+writes no files; these are also the bits of a frame's FLAGS.
+-------------------------------------------------------------*/
+enum
+{
+  EMIT_RAW     = 1,
+  EMIT_DECODED = 2,
+  EMIT_BOTH    = 3
+};
 
-    defs = position + 0x10U;
-  }
 
-  do
-  {
-    if ( masks == 0 )
-    {
-      if ( magic != Yaz )
-      {
-        if ( magic != SMSR )
-        {
-          operations = (i32)_swap32( *(u32 *)&srcbuf[flags] );
-          masks  = 32U;
-          flags += 4U;
-        }
-        else
-        {
-          operations = (i32)_swap16( *(u16 *)&srcbuf[poly] );
-          operations <<= 0x10;
-          masks = 16U;
-          poly += 2U;
-        }
-      }
-      else
-      {
-        operations   = (i32)srcbuf[defs++];
-        operations <<= 0x18;
-        masks = 8U;
-      }
-    }
-    else
-    {
-      if ( operations >= 0 )
-      {
-        displacement = (u32)_swap16( *(u16 *)((magic != Yaz) ?
-                                              &srcbuf[poly]  :
-                                              &srcbuf[defs]) );
-        previous = *dst - ((displacement & 0x00000FFFU) + 1U);
 
-        if ( magic != Yaz )
-        {
-          poly += 2U;
-        }
-        else
-        {
-          defs += 2U;
-        }
+/*-----------------------------------------------------------------
+Where progress and diagnostic messages are printed; this is stderr
+whenever the standard output carries a machine-readable listing
+or a stream of frames.
+-----------------------------------------------------------------*/
+static FILE *statusFile;
 
-        if (    ((displacement >> 12) == 0)
-             && (magic != MIO)
-             && (magic != SMSR) )
-        {
-          displacement = (u32)srcbuf[defs++] + 18U;
-        }
-        else
-        {
-          displacement = (displacement >> 12) + 2U;
+#ifdef XSLI_WATCH
+/*-----------------------------------------------------------
+Where a "--watch" worker keeps the messages of the ROM it is
+processing instead, until it is done; see "_watchWorker".
+-----------------------------------------------------------*/
+static __thread FILE *statusLog;
 
-          if ( (magic == MIO) || (magic == SMSR) )
-          {
-            ++displacement;
-          }
-        }
+#define STATUS ((statusLog != (FILE *)0) ? statusLog : statusFile)
+#else
+#define STATUS statusFile
+#endif
 
-        while ( *(*dst)++ = *previous++, --displacement );
-      }
-      else
-      {
-        *(*dst)++ = srcbuf[defs++];
-      }
 
-      operations <<= 1;
-      --masks;
-    }
-  }
-  while ( *dst < dest );
-  
-  *dst -= sizeDecoded;
 
-  return;
-}
+#ifdef XSLI_THREADS
+/*------------------------------------------------------------
+How many worker threads "-j" asks for; online CPUs otherwise.
+------------------------------------------------------------*/
+#define THREADS_MAX 64
 
+static u32 threads;
+#endif
 
 
-static void writeSLI( const u8 *srcbuf,
-                      register u32 *position, const u32 blockLength,
-                      u32 *hits, const u32 fourCC, const u32 magic,
-                      const char *gameID,
-                      const char *gameName,
-                      const char *path )
+
+/*--------------------------------------------------------------------
+The format registry, one descriptor for each format in "formats", in
+the order of the slots of counters kept by format. A block found by
+the scan is handed on with its "magic", by which the descriptor is
+looked up wherever it's measured, decoded, named or written out; the
+"kernel" it's handed to is that of the coding it shares, if any.
+
+  signature : FourCC the scan looks for; 0 for "lead" alone.
+  lead      : Leading byte of a candidate, see "_buildLeads".
+  tag       : FourCC naming it in frames and replies.
+  getSize   : Decoded size, from the header at "position".
+  measure   : As "getBlockLength"; NULL where the header has it.
+  decode    : As "decbuf".
+  check     : As "_decodeChecked".
+
+"FMT_ALL" is what's scanned for unless "-f" says otherwise; formats
+found by a leading byte alone must be asked for by name.
+--------------------------------------------------------------------*/
+#define FMT_MIO  (1U << 0)
+#define FMT_YAY  (1U << 1)
+#define FMT_YAZ  (1U << 2)
+#define FMT_CMPR (1U << 3)
+#define FMT_YAZ1 (1U << 4)
+#define FMT_LZ10 (1U << 5)
+#define FMT_LZ11 (1U << 6)
+#define FMT_ALL  (FMT_MIO | FMT_YAY | FMT_YAZ | FMT_CMPR | FMT_YAZ1)
+
+/*-------------------------------------------------------------
+"measure" returns EXIT_SUCCESS for a block, EXIT_FAILURE for a
+malformed one [an oddity], or MEASURE_NONE for no block at all.
+-------------------------------------------------------------*/
+#define MEASURE_NONE 2
+
+enum
 {
-  FILE *SLI     = (FILE *)0;
-  FILE *DECODED = (FILE *)0;
-  char *dataEntry   = (char *)calloc( FILENAME_MAX, sizeof(char) );
-  char *decodedDest = (char *)0;
+  FORMAT_MIO,
+  FORMAT_YAY,
+  FORMAT_YAZ,
+  FORMAT_CMPR,
+  FORMAT_YAZ1,
+  FORMAT_LZ10,
+  FORMAT_LZ11,
+  FORMAT_SLOTS
+};
+
+struct format
+{
+  u32 magic;
+  u32 signature;
+  u32 lead;
+  u32 tag;
+  u32 kernel;
+  u32 bit;
+  const char *name;
+  const char *extension;
+  u32  (*getSize)();
+  int  (*measure)();
+  void (*decode)();
+  int  (*check)();
+};
+
+struct shape;
+
+static u32  _getSizeSLI();
+static u32  _getSizeSMSR();
+static u32  _getSizeLZ();
+static int  getBlockLength();
+static int  _getLZLength();
+static void decbuf();
+static void _decodeLZ();
+static int  _decodeChecked();
+static int  _checkLZ();
+
+static const struct format formats[FORMAT_SLOTS + 1] =
+{
+  { MIO,  MIO,  0x4DU, MIO,  MIO,  FMT_MIO,  "MIO0", EXT_SZP,
+    _getSizeSLI,  getBlockLength, decbuf,    _decodeChecked },
+  { Yay,  Yay,  0x59U, Yay,  Yay,  FMT_YAY,  "Yay0", EXT_SZP,
+    _getSizeSLI,  getBlockLength, decbuf,    _decodeChecked },
+  { Yaz,  Yaz,  0x59U, Yaz,  Yaz,  FMT_YAZ,  "Yaz0", EXT_SZS,
+    _getSizeSLI,  getBlockLength, decbuf,    _decodeChecked },
+  /*-------------------------------------------------------------
+  Found as "CMPR", and handed on as the "SMSR00" block it wraps.
+  -------------------------------------------------------------*/
+  { SMSR, CMPR, 0x43U, CMPR, SMSR, FMT_CMPR, "CMPR", EXT_SZP,
+    _getSizeSMSR, 0,              decbuf,    _decodeChecked },
+  { Yaz1, Yaz1, 0x59U, Yaz1, Yaz,  FMT_YAZ1, "Yaz1", EXT_SZS,
+    _getSizeSLI,  getBlockLength, decbuf,    _decodeChecked },
+  { LZ10, 0,    0x10U, LZ10, LZ10, FMT_LZ10, "LZ10", EXT_LZ,
+    _getSizeLZ,   _getLZLength,   _decodeLZ, _checkLZ },
+  { LZ11, 0,    0x11U, LZ11, LZ11, FMT_LZ11, "LZ11", EXT_LZ,
+    _getSizeLZ,   _getLZLength,   _decodeLZ, _checkLZ },
+  /*-------------------------------------------
+  Anything else, handed to the SLI kernels as
+  it always was.
+  -------------------------------------------*/
+  { 0,    0,    0,     0x3F3F3F3FU, 0, 0,    "????", EXT_SZP,
+    _getSizeSLI,  getBlockLength, decbuf,    _decodeChecked }
+};
+
+/*--------------------------------------------------------------
+Bit "slot" of "leads[b]" is set for each format scanned for whose
+candidates start with the byte "b".
+--------------------------------------------------------------*/
+static u8 leads[256];
+
+
+
+static const struct format *_getFormatInfo( const u32 magic )
+{
+  register const struct format *format = formats;
 
-  if ( dataEntry == (char *)0 )
+  while ( (format->magic != magic) && (format->tag != magic) )
   {
-    if ( options.verbose != 0 )
+    if ( ++format == &formats[FORMAT_SLOTS] )
     {
-      printf( "\n>>> Unable to allocate for file name!\n\n" );
+      break;
     }
-
-    goto err;
   }
 
-  if ( options.toDecode != 0 )
-  {
-    decodedDest = (char *)calloc( FILENAME_MAX, sizeof(char) );
+  return format;
+}
 
-    if ( decodedDest == (char *)0 )
-    {
-      if ( options.verbose != 0 )
-      {
-        printf( "\n>>> Unable to allocate for decoded file name!\n\n" );
-      }
 
-      goto err;
-    }
-  }
 
-  if ( ((fourCC != 0) && (options.useGameName != 0)) )
-  {
-    sprintf( dataEntry, "%s[%s]_%s_[0x%X]",
-             path, gameID, gameName, *position );
-  }
-  else
-  {
-    sprintf( dataEntry, "%s0x%X", path, *position );
-  }
+/*-----------------------------------------------------------
+Anything not registered is counted with CMPR, as it always was.
+-----------------------------------------------------------*/
+static int _getFormatSlot( const u32 magic )
+{
+  int slot = (int)(_getFormatInfo( magic ) - formats);
 
-  if ( options.toDecode != 0 )
-  {
-    sprintf( decodedDest, "%s", dataEntry );
-  }
+  return (slot < FORMAT_SLOTS) ? slot : FORMAT_CMPR;
+}
 
-  strcat( dataEntry, ((magic != Yaz) ? EXT_SZP : EXT_SZS) );
 
-  if ( (SLI = fopen( dataEntry, "wb" )) == (FILE *)0 )
+
+/*--------------------------------------------------------------
+A block's decoded size, and its decoding with or without checks,
+as its descriptor has them; "block" is in Big-Endian order.
+--------------------------------------------------------------*/
+static u32 _getDecodedSize( const u8 *block, const u32 magic )
+{
+  return _getFormatInfo( magic )->getSize( block, (u32)0, (u32)0 );
+}
+
+static void _decodeBlock( const u8 *block, u8 **dst, const u32 magic,
+                          const u32 sizeDecoded )
+{
+  const struct format *format = _getFormatInfo( magic );
+
+  format->decode( block, dst, (u32)0, format->kernel, sizeDecoded );
+  return;
+}
+
+static int _checkBlock( const u8 *block, const u32 blockLength,
+                        const u32 magic, u8 *dst, const u32 sizeDecoded,
+                        struct shape *shape )
+{
+  const struct format *format = _getFormatInfo( magic );
+
+  return format->check( block, blockLength, format->kernel,
+                        dst, sizeDecoded, shape );
+}
+
+
+
+static void _buildLeads( const u32 scanned )
+{
+  int slot;
+
+  memset( leads, 0, sizeof(leads) );
+
+  for ( slot = 0; slot < FORMAT_SLOTS; ++slot )
   {
-    if ( options.verbose != 0 )
+    if ( (formats[slot].bit & scanned) != 0 )
     {
-      printf( "\n>>> Unable to create SLI file!\n\n" );
+      leads[formats[slot].lead] |= (u8)(1U << slot);
     }
-
-    goto err;
   }
 
-  if ( options.toDecode != 0 )
+  return;
+}
+
+
+
+/*-----------------------------------------------------------------
+The format of the candidate at a byte "kinds" was looked up for in
+"leads", for a "magic" read at it, among those that are measured.
+-----------------------------------------------------------------*/
+static const struct format *_getCandidate( const u32 kinds, const u32 magic )
+{
+  int slot;
+
+  for ( slot = 0; slot < FORMAT_SLOTS; ++slot )
   {
-    if ( (DECODED = fopen( decodedDest, "wb" )) == (FILE *)0 )
+    if (    ((kinds & (1U << slot)) != 0)
+         && (formats[slot].measure != 0)
+         && (    (formats[slot].signature == magic)
+              || (formats[slot].signature == 0) ) )
     {
-      if ( options.verbose != 0 )
-      {
-        printf( "\n>>> Unable to create Decoded file!\n\n" );
-      }
-
-      goto err;
+      return &formats[slot];
     }
   }
 
-  if ( options.toDecode != 0 )
-  {
-    u32 sizeDecoded = 0;
-    u8 *dst = (u8 *)0;
+  return (const struct format *)0;
+}
 
-    if ( magic == SMSR )
-    {
-      sizeDecoded = _swap32( *(u32 *)&srcbuf[*position + 0x08U] );
-    }
-    else
+
+
+#ifdef XSLI_METRICS
+/*--------------------------------------------------------------------
+"-x" counters, kept by each thread in a "meter" of its own that only
+it ever writes, with relaxed atomic stores, so that counting costs no
+lock and no contended cache line. The sampling thread sums all the
+meters with relaxed atomic loads; see "_putMetrics".
+
+Decode and write latencies are taken from the same stage markers as
+"-t", and put into buckets of at most 100us, 1ms, 10ms, 100ms, 1s
+and beyond. Bytes scanned are counted as each scan starts.
+--------------------------------------------------------------------*/
+#define METER_BUCKETS 6
+
+struct meter
+{
+  struct meter *next;
+  unsigned long roms;
+  unsigned long failures;
+  unsigned long scanned;
+  unsigned long candidates[FORMAT_SLOTS];
+  unsigned long hits[FORMAT_SLOTS];
+  unsigned long rejects[FORMAT_SLOTS];
+  unsigned long filtered[FORMAT_SLOTS];
+  unsigned long decoded;
+  unsigned long written;
+  /*-----------------------------------------------------
+  Stage 0 is decoding and stage 1 writing; "latencySum"
+  is in microseconds, and "since" is only for the owner.
+  -----------------------------------------------------*/
+  unsigned long latency[2][METER_BUCKETS];
+  unsigned long latencySum[2];
+  struct timespec since[2];
+};
+
+static struct
+{
+  const char *path;
+  struct meter *meters;
+  unsigned isEnabled;
+  u32 romsQueued;
+}
+metrics;
+
+static __thread struct meter *meterLocal;
+
+static struct meter *_getMeter( void )
+{
+  struct meter *meter = meterLocal;
+  struct meter *head;
+
+  if ( meter == (struct meter *)0 )
+  {
+    if ( (meter = (struct meter *)calloc( 1, sizeof(*meter) ))
+         == (struct meter *)0 )
     {
-      sizeDecoded = _swap32( *(u32 *)&srcbuf[*position + 0x04U] );
+      return (struct meter *)0;
     }
-    
-    decbuf( srcbuf, &dst, *position, magic, sizeDecoded );
 
-    if ( dst == (u8 *)0 )
-    {
-      if ( options.verbose != 0 )
-      {
-        printf( "\n>>> Unable to decode data segment!\n\n" );
-      }
+    head = (struct meter *)0;
 
-      goto err;
-    }
-    else
+    do
     {
-      fwrite( dst, sizeof(u8), sizeDecoded, DECODED );
-      fflush( DECODED );
-      fclose( DECODED );
-      free( dst );
-      dst = (u8 *)0;
+      meter->next = head;
+      head = __sync_val_compare_and_swap( &metrics.meters, head, meter );
     }
+    while ( head != meter->next );
+
+    meterLocal = meter;
   }
 
-  srcbuf += *position;
-  fwrite( srcbuf, sizeof(u8), blockLength, SLI );
-  *position += blockLength;
-  srcbuf -= *position;
-  fflush( SLI );
-  fclose( SLI );
-  free( decodedDest );
-  decodedDest = (char *)0;
-  free( dataEntry );
-  dataEntry = (char *)0;
-  (*hits)++;
-  return;
+  return meter;
+}
 
-err:
+#define METER_ADD( field, amount )                                      \
+        do                                                              \
+        {                                                               \
+          struct meter *meter_;                                         \
+                                                                        \
+          if (    (metrics.isEnabled != 0)                              \
+               && ((meter_ = _getMeter()) != (struct meter *)0) )       \
+          {                                                             \
+            __atomic_store_n( &meter_->field,                           \
+                              meter_->field + (unsigned long)(amount),  \
+                              __ATOMIC_RELAXED );                       \
+          }                                                             \
+        }                                                               \
+        while ( 0 )
+
+static void _meterStage( const int stage, const int phase,
+                         const struct timespec *now )
+{
+  static const unsigned long bounds[METER_BUCKETS - 1] =
+  {
+    100UL, 1000UL, 10000UL, 100000UL, 1000000UL
+  };
+  struct meter *meter;
+  unsigned long micro;
+  int bucket = 0;
 
-  *position = cleanUpOnError( SLI, DECODED, dataEntry, decodedDest );
+  if ( (meter = _getMeter()) == (struct meter *)0 )
+  {
+    return;
+  }
+
+  if ( phase == 'B' )
+  {
+    meter->since[stage] = *now;
+    return;
+  }
+
+  micro = (unsigned long)(now->tv_sec - meter->since[stage].tv_sec) *
+          1000000UL;
+  micro = micro + (unsigned long)(now->tv_nsec / 1000L) -
+                  (unsigned long)(meter->since[stage].tv_nsec / 1000L);
+
+  while ( (bucket < (METER_BUCKETS - 1)) && (micro > bounds[bucket]) )
+  {
+    ++bucket;
+  }
+
+  METER_ADD( latency[stage][bucket], 1 );
+  METER_ADD( latencySum[stage], micro );
   return;
 }
+#else
+#define METER_ADD( field, amount ) ((void)0)
+#endif
 
 
 
-static int getBlockLength( const u8 *srcbuf, const u32 position,
-                           const u32 magic, register u32 *blockLength )
+#ifdef XSLI_TRACE
+/*--------------------------------------------------------------------
+"-t" records when each stage of the work on a ROM and its blocks
+begins and ends, to be written out as a Chrome trace once the run is
+over. Every thread appends to a buffer of its own, which it links
+into "trace.buffers" with a compare-and-swap on its first event, so
+that no thread ever waits on another while recording. A buffer holds
+"TRACE_EVENTS" at most, as "-u" and "--watch" never end a run,
+and events past that are counted as dropped.
+--------------------------------------------------------------------*/
+#define TRACE_EVENTS 0x100000U /* 24 MiB a thread */
+
+enum
 {
-  u32 offset = 0;
-  u32 masks  = 0;
-  u32 flags  = 0;
-  u32 poly   = 0;
-  u32 defs   = 0;
-  u32 displacement;
-  u32 sizeDecoded = _swap32( *(u32 *)&srcbuf[position + 0x04U] );
-  i32 operations;
+  TRACE_LOAD,
+  TRACE_ORDER,
+  TRACE_LENGTH,
+  TRACE_DECODE,
+  TRACE_WRITE
+};
+
+struct event
+{
+  double time;   /* Microseconds since the trace began */
+  u32 offset;
+  u32 magic;     /* Zero for events that aren't about a block */
+  u8  kind;
+  u8  phase;     /* 'B'egin or 'E'nd */
+};
+
+struct traceBuffer
+{
+  struct traceBuffer *next;
+  struct event *events;
+  u32 count;
+  u32 capacity;
+  u32 thread;
+  u32 dropped;
+};
 
-  if ( (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU) )
+static struct
+{
+  const char *path;
+  struct traceBuffer *buffers;
+  struct timespec start;
+  u32 threads;
+}
+trace;
+
+static __thread struct traceBuffer *traceLocal;
+
+static void _traceEvent( const int kind, const int phase,
+                         const u32 offset, const u32 magic )
+{
+  struct traceBuffer *buffer = traceLocal;
+  struct traceBuffer *head;
+  struct timespec now;
+  struct event *event;
+
+#ifdef XSLI_METRICS
+  if ( (trace.path == (const char *)0) && (metrics.isEnabled == 0) )
   {
-    return EXIT_FAILURE;
+    return;
   }
 
-  if ( magic != Yaz )
-  {
-    poly = _swap32( *(u32 *)&srcbuf[position + 0x08U] );
-    defs = _swap32( *(u32 *)&srcbuf[position + 0x0CU] );
+  clock_gettime( CLOCK_MONOTONIC, &now );
 
-    if ( (poly == 0) || (defs < poly) )
-    {
-      return EXIT_FAILURE;
-    }
+  if (    (metrics.isEnabled != 0)
+       && ((kind == TRACE_DECODE) || (kind == TRACE_WRITE)) )
+  {
+    _meterStage( (kind == TRACE_WRITE), phase, &now );
+  }
 
-    poly += position;
-    defs += position;
-    flags = position + 0x10U;
+  if ( trace.path == (const char *)0 )
+  {
+    return;
   }
-  else
+#else
+  if ( trace.path == (const char *)0 )
   {
-    if (    (_swap32( *(u32 *)&srcbuf[position + 0x08U] ) != 0)
-         || (_swap32( *(u32 *)&srcbuf[position + 0x0CU] ) != 0) )
-    {
-      return EXIT_FAILURE;
-    }
-
-    defs = position + 0x10U;
+    return;
   }
 
-  *blockLength = 16U;
+  clock_gettime( CLOCK_MONOTONIC, &now );
+#endif
 
-  do
+  if ( buffer == (struct traceBuffer *)0 )
   {
-    if ( masks == 0 )
+    if ( (buffer = (struct traceBuffer *)calloc( 1, sizeof(*buffer) ))
+         == (struct traceBuffer *)0 )
     {
-      if ( magic != Yaz )
-      {
-        operations = (i32)_swap32( *(u32 *)&srcbuf[flags] );
-        masks  = 32U;
-        flags += 4U;
-        *blockLength += 4U;
-      }
-      else
-      {
-        operations = (i32)srcbuf[defs++];
-        operations <<= 0x18;
-        masks = 8U;
-        *blockLength += 1U;
-      }
+      return;
     }
-    else
-    {
-      if ( operations >= 0 )
-      {
-        displacement = (u32)_swap16( *(u16 *)((magic != Yaz) ?
-                                              &srcbuf[poly]  :
-                                              &srcbuf[defs]) );
 
-        if ( magic != Yaz )
-        {
-          poly += 2U;
-        }
-        else
-        {
-          defs += 2U;
-        }
+    buffer->thread = __sync_add_and_fetch( &trace.threads, 1U );
+    head = (struct traceBuffer *)0;
 
-        if ( ((displacement >> 12) == 0) && (magic != MIO) )
-        {
-          displacement  = srcbuf[defs++] + 18U;
-          *blockLength += 3U;
-        }
-        else
-        {
-          displacement = (displacement >> 12) + 2U;
+    /*-----------------------------------------------------------
+    Each attempt guesses the head of the list, and learns the
+    actual one from the swap when the guess was wrong.
+    -----------------------------------------------------------*/
+    do
+    {
+      buffer->next = head;
+      head = __sync_val_compare_and_swap( &trace.buffers, head, buffer );
+    }
+    while ( head != buffer->next );
 
-          if ( magic == MIO )
-          {
-            ++displacement;
-          }
+    traceLocal = buffer;
+  }
 
-          *blockLength += 2U;
-          }
+  if ( buffer->count == TRACE_EVENTS )
+  {
+    buffer->dropped++;
+    return;
+  }
 
-        offset += displacement;
-      }
-      else
-      {
-        ++defs;
-        ++offset;
-        (*blockLength)++;
-      }
+  if ( buffer->count == buffer->capacity )
+  {
+    u32 capacity = (buffer->capacity != 0) ? (buffer->capacity << 1) :
+                                             0x1000U;
 
-      operations <<= 1;
-      --masks;
+    if ( (event = (struct event *)realloc( buffer->events,
+                                           sizeof(struct event) * capacity ))
+         == (struct event *)0 )
+    {
+      buffer->dropped++;
+      return;
     }
+
+    buffer->events   = event;
+    buffer->capacity = capacity;
   }
-  while ( offset < sizeDecoded );
 
-  return EXIT_SUCCESS;
+  event = &buffer->events[buffer->count++];
+  event->time   = (double)(now.tv_sec  - trace.start.tv_sec) * 1.0e6 +
+                  (double)(now.tv_nsec - trace.start.tv_nsec) / 1.0e3;
+  event->offset = offset;
+  event->magic  = magic;
+  event->kind   = (u8)kind;
+  event->phase  = (u8)phase;
+  return;
 }
 
+#define TRACE_BEGIN( kind, offset, magic ) \
+        _traceEvent( (kind), 'B', (offset), (magic) )
+#define TRACE_END( kind, offset, magic ) \
+        _traceEvent( (kind), 'E', (offset), (magic) )
+#else
+#define TRACE_BEGIN( kind, offset, magic ) ((void)0)
+#define TRACE_END( kind, offset, magic )   ((void)0)
+#endif
 
 
-static void postDiscrepancy( const u8 *srcbuf,
-                             const u32 position, const u32 oddities )
+
+/*--------------------------------------------------------------------
+Buffers reused for the length of a run, one per kind and nesting
+depth, so that a ROM with thousands of blocks costs a handful of
+allocations rather than several per block. A buffer only ever grows,
+is never zero-filled, and hands back whatever it held last.
+--------------------------------------------------------------------*/
+enum
 {
-  printf( "___[#%u]___QUESTIONABLE_DATA_SEQUENCE___\n"
-          "0x%X -> [0x%X]\n0x%X -> [0x%X]\n0x%X -> [0x%X]\n0x%X -> [0x%X]\n",
-          oddities,
-          position, _swap32(*(u32 *)(srcbuf + position)),
-          (u32)(position + 0x4U), _swap32(*(u32 *)&srcbuf[position + 0x04U]),
-          (u32)(position + 0x8U), _swap32(*(u32 *)&srcbuf[position + 0x08U]),
-          (u32)(position + 0xCU), _swap32(*(u32 *)&srcbuf[position + 0x0CU]) );
-  return;
-}
+  POOL_ROM,     /* Whole ROM, depth 0 only */
+  POOL_BLOCK,   /* Block put into Big-Endian order */
+  POOL_DECODED, /* Decoded data */
+  POOL_NAME,    /* File name of a block */
+  POOL_DEST,    /* File name of decoded data */
+  POOL_REGION,  /* Region map, depth 0 only */
+  POOL_CODED,   /* Block transcoded by "-w" */
+  POOL_LIST,    /* Reply to a "-u" listing, depth 0 only */
+  POOL_KINDS
+};
 
 
 
-static void scanSLI( u8 *srcbuf,
-                     const u32 lengthROM, const u32 fourCC,
-                     const char *path )
+struct pool
 {
-  /*----------------------
-  FourCC + NULL Terminator
-  ----------------------*/
-  char gameID[5];
-  /*-----------------------------
-  20 Byte Frame + NULL Terminator
-  -----------------------------*/
-  char gameName[21];
-  u32 magic = 0;
-  u32 id32  = 0;
-  u32 blockLength = 0;
-  u32 hits = 0;
-  u32 oddities = 0;
-  u32 position = 0;
-  unsigned hasGZIP = 0;
-  /*------------------------------------------------------------
-  Some enumerated values pertaining to Game IDs for titles that
-  have quirks, or are problematic from unresolved discrepancies.
-  ------------------------------------------------------------*/
-  enum
-  {
-    /*--------------------
-    Game IDs: Body Harvest
-    --------------------*/
-    NBHE = 0x4E424845U, /* NTSC */
-    NBHP = 0x4E424850U, /* PAL */
-    /*------------------------------------------------------
-    Game IDs: Looney Tunes: Duck Dodgers Starring Daffy Duck
-    ------------------------------------------------------*/
-    /*NDUE = 0x4E445545,
-    NDUP = 0x4E445550,*/
-    /*----------------------------------------
-    Game IDs: Scooby-Doo! Classic Creep Capers
-    ----------------------------------------*/
-    NSYE = 0x4E535945U, /* NTSC */
-    NSYP = 0x4E535950U  /* PAL */
-  };
+  u8 *data[POOL_KINDS][DEPTH_MAX + 1];
+  u32 size[POOL_KINDS][DEPTH_MAX + 1];
+  u32 requested;
+  u32 allocated;
+  size_t total;       /* May pass 4 GiB over a long run */
+  u32 held;
+  u32 peak;
+};
 
-  if ( (fourCC != 0) && (options.useGameName != 0) )
+
+
+static void *_poolGet( struct pool *pool, const int kind,
+                       const u32 depth, const u32 size )
+{
+  u8 **data = &pool->data[kind][depth];
+  u32 *held = &pool->size[kind][depth];
+
+  pool->requested++;
+
+  if ( size > *held )
   {
-    int j = 0;
+    /*----------------------------------------------------------
+    Grows by at least half again, in 4 KiB steps, and without
+    "realloc", as the old contents don't need to be carried over.
+    ----------------------------------------------------------*/
+    u32 grown = *held + (*held >> 1);
 
-    id32 = _swap32( *(u32 *)&srcbuf[0x3BU] );
+    grown = (((grown > size) ? grown : size) + 0xFFFU) & ~0xFFFU;
 
-    while ( j < 4 )
+    free( *data );
+    pool->held -= *held;
+    *held = 0;
+
+    if ( (*data = (u8 *)malloc( grown )) == (u8 *)0 )
     {
-      gameID[j] = (char)srcbuf[0x3BU + j];
-      ++j;
+      return (void *)0;
     }
 
-    gameID[j] = '\0';
-    j = 0;
+    *held = grown;
+    pool->allocated++;
+    pool->total += grown;
+    pool->held  += grown;
 
-    while ( j < 20 )
+    if ( pool->held > pool->peak )
     {
-      gameName[j] = (char)srcbuf[0x20U + j];
+      pool->peak = pool->held;
+    }
+  }
 
-      if ( j < 19 )
-      {
-        if ( (gameName[j] == ' ') && (gameName[j + 1] != ' ') )
-        {
-          gameName[j] = '_';
-        }
+  return (void *)*data;
+}
 
-        if ( (((char)srcbuf[0x20U + j    ] == (char)0x20U) &&
-              ((char)srcbuf[0x20U + j + 1] == (char)0x20U)) )
-        {
-          goto space;
-        }
-      }
-      else
-      {
-space:  gameName[j] = '\0';
-        break;
-      }
 
-      ++j;
+
+static void _poolFree( struct pool *pool )
+{
+  int kind = 0;
+
+  while ( kind < POOL_KINDS )
+  {
+    u32 depth = 0;
+
+    while ( depth <= DEPTH_MAX )
+    {
+      free( pool->data[kind][depth] );
+      pool->data[kind][depth] = (u8 *)0;
+      pool->size[kind][depth] = 0;
+      ++depth;
     }
+
+    ++kind;
   }
 
-  while ( position < lengthROM )
+  pool->held = 0;
+  return;
+}
+
+
+
+/*-----------------------------------------------------------------
+Blocks found by a scan, kept for "-u" in place of being listed.
+"offset" is that of the Big-Endian block within the scanned data.
+-----------------------------------------------------------------*/
+struct hit
+{
+  u32 offset;
+  u32 magic;
+  u32 raw;
+  u32 decoded;
+};
+
+struct index
+{
+  struct hit *hits;
+  u32 count;
+  u32 capacity;
+  unsigned isTruncated;
+};
+
+
+
+struct tally
+{
+  struct pool *pool;
+  struct index *index;
+  const char *pathROM;
+  /*----------------------------------------------------------------
+  Descriptor of the ROM file while its bytes are the same as those
+  being scanned, for blocks to be copied from directly; otherwise -1.
+  ----------------------------------------------------------------*/
+  int fdROM;
+  u32 zeroCopies;
+  /*-----------------------------------------------------------
+  Region map of the data scanned at depth 0, if there is one,
+  and how many of its bytes the scan stepped over for it.
+  -----------------------------------------------------------*/
+  const u8 *regions;
+  u32 skipped;
+  /*-----------------------------------------------------------
+  Where walks count how each block was encoded, with "-z" only.
+  -----------------------------------------------------------*/
+  struct shape *shape;
+  u32 hits;
+  u32 oddities;
+  u32 nested;
+  u32 filtered;
+  u32 carved;
+};
+
+
+
+static void scanSLI();
+
+
+
+static u32 cleanUpOnError( FILE *SLI, FILE *DECODED,
+                           char *dataEntry, char *decodedDest )
+{
+  if ( SLI != (FILE *)0 )
   {
-    magic = _swap32( *(u32 *)&srcbuf[position] );
+    fclose( SLI );
 
-    if ( (magic == MIO) || (magic == Yay) || (magic == Yaz) )
+    if ( dataEntry != (char *)0 )
     {
-      /*-----------------------------------------------------------
-      Hack to keep from crashing when dumping from Scooby-Doo! CCC.
-      This hasn't been tested for accuracy or inadvertent deficits.
-      -----------------------------------------------------------*/
-      if ( (id32 == NSYE) || (id32 == NSYP) )
-      {
-        if ( (position & 1) != 0 )
-        {
-          ++oddities;
+      remove( dataEntry );
+    }
+  }
 
-          if ( options.verbose != 0 )
-          {
-            postDiscrepancy( srcbuf, position, oddities );
-          }
+  if ( DECODED != (FILE *)0 )
+  {
+    fclose( DECODED );
 
-          goto next;
-        }
-      }
+    if ( decodedDest != (char *)0 )
+    {
+      remove( decodedDest );
+    }
+  }
 
-      if ( magic == MIO )
-      {
-        if ( (id32 == NBHE) || (id32 == NBHP) )
-        {
-          /*----------------------------------------------------
-          DMA Design Limited [a.k.a. Rockstar North] used a
-          non-standard SLI header in their title "Body Harvest".
-          Instead of using the standard 16-Byte header,
-          they used a 20-Byte header that deviates as such:
+  return 0;
+}
 
-          MM = Magic, DD = DecodedSize,
-          PP = Offset to Pointers, RR = Offset to Raw Bytes
 
-          MMMMMMMM BLOCKLEN DDDDDDDD PPPPPPPP
-          RRRRRRRR
-          ----------------------------------------------------*/
-          position += 4U;
-          blockLength = _swap32( *(u32 *)&srcbuf[position] ) - 4U;
-          *(u32 *)&srcbuf[position        ] = _swap32( magic );
-          *(u32 *)&srcbuf[position + 0x08U] =
-            _swap32( _swap32( *(u32 *)&srcbuf[position + 0x08U] ) - 4U );
-          *(u32 *)&srcbuf[position + 0x0CU] =
-            _swap32( _swap32( *(u32 *)&srcbuf[position + 0x0CU] ) - 4U );
-          writeSLI( srcbuf, &position, blockLength,
-                    &hits, fourCC, magic,
-                    gameID, gameName, path );
 
-          if ( position == 0 )
-          {
-            return;
-          }
+#ifdef XSLI_THREADS
+/*---------------------------------------------------------------------
+Yay0/Yaz0 blocks decoding to "SPLIT_MIN" bytes or more are decoded by
+"-j" threads at once. A first pass walks the tokens without copying
+anything, as "getBlockLength" does, and takes a checkpoint of where
+each stream is at roughly every "length" bytes of output. Threads then
+decode the pieces between checkpoints in any order, putting off each
+back-reference that reaches before its piece, or into bytes put off
+already; those are copied afterwards, piece by piece from the first,
+by when everything they can reach is in place. The output is the same
+as that of the serial path, byte for byte.
+---------------------------------------------------------------------*/
+#define SPLIT_MIN   0x400000U /* 4 MiB */
+#define SPLIT_PIECE 0x10000U  /* Smallest piece */
 
-          goto next;
-        }
-        else
-        {
-          /*------------------------------------------------------------
-          Hack to keep the program from crashing when dumping from
-          Looney Tunes: Duck Dodgers Starring Daffy Duck.
-          It seems that if the FourCC "MIO0" isn't preceded by "GZIP"
-          16 bytes prior, the "MIO0" header contains unusual information
-          at 0x8 and 0xC which will cause this program to crash.
-          ------------------------------------------------------------*/
-          u32 code = _swap32( *(u32 *)&srcbuf[position - 0x10U] );
+/*----------------------------------------------------------------
+Cleared where the "-j" threads are each busy with a ROM of their
+own [--watch], so that none of them splits a block "-j" ways more.
+----------------------------------------------------------------*/
+static unsigned isSplitting = 1;
 
-          if ( !hasGZIP && (code == GZIP) )
-          {
-            hasGZIP = !hasGZIP;
-          }
-          else
-          {
-            if ( hasGZIP && (code != GZIP) )
-            {
-              ++oddities;
+struct checkpoint
+{
+  u32 out;
+  u32 flags;
+  u32 poly;
+  u32 defs;
+  u32 masks;
+  i32 operations;
+};
 
-              if ( options.verbose != 0 )
-              {
-                postDiscrepancy( srcbuf, position, oddities );
-              }
+/*----------------------------------------------------------
+A back-reference put off by a piece; what it will write is
+kept as ranges too, in order, to find what depends on it.
+----------------------------------------------------------*/
+struct deferral
+{
+  u32 out;
+  u32 distance;
+  u32 length;
+};
 
-              goto next;
-            }
-          }
+struct piece
+{
+  struct deferral *deferrals;
+  u32 count;
+  u32 capacity;
+  unsigned isFailed;
+};
+
+struct split
+{
+  const u8 *block;
+  u8 *dst;
+  u32 magic;
+  u32 count;
+  u32 next;
+  struct checkpoint *checkpoints;
+  struct piece *pieces;
+};
+
+
+
+static int _deferCopy( struct piece *piece, const u32 out,
+                       const u32 distance, const u32 length )
+{
+  struct deferral *deferral;
+
+  if ( piece->count == piece->capacity )
+  {
+    u32 capacity = (piece->capacity != 0) ? (piece->capacity << 1) : 64U;
+
+    if ( (deferral = (struct deferral *)realloc( piece->deferrals,
+                                    sizeof(struct deferral) * capacity ))
+         == (struct deferral *)0 )
+    {
+      return 1;
+    }
+
+    piece->deferrals = deferral;
+    piece->capacity  = capacity;
+  }
+
+  deferral = &piece->deferrals[piece->count++];
+  deferral->out      = out;
+  deferral->distance = distance;
+  deferral->length   = length;
+  return 0;
+}
+
+
+
+/*-------------------------------------------------------------
+Whether any of "from" up to "to" is yet to be written by one of
+the piece's deferrals; only those within 4 KiB can be reached.
+-------------------------------------------------------------*/
+static int _isDeferred( const struct piece *piece, const u32 from,
+                        const u32 to )
+{
+  u32 i = piece->count;
+
+  while ( i != 0 )
+  {
+    const struct deferral *deferral = &piece->deferrals[--i];
+
+    if ( (deferral->out + deferral->length) <= from )
+    {
+      break;
+    }
+
+    if ( deferral->out < to )
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+
+static void *_fillPieces( void *argument )
+{
+  struct split *split = (struct split *)argument;
+  const u8 *block = split->block;
+  u8 *dst = split->dst;
+  u32 k;
+
+  while ( (k = __sync_fetch_and_add( &split->next, 1U )) < split->count )
+  {
+    struct checkpoint at = split->checkpoints[k];
+    struct piece *piece  = &split->pieces[k];
+    u32 start = at.out;
+    u32 end   = split->checkpoints[k + 1U].out;
+
+    while ( at.out < end )
+    {
+      if ( at.masks == 0 )
+      {
+        if ( split->magic == Yay )
+        {
+          at.operations = (i32)_peek32( block, at.flags, 0 );
+          at.masks  = 32U;
+          at.flags += 4U;
+        }
+        else
+        {
+          at.operations = (i32)((u32)block[at.defs++] << 24);
+          at.masks = 8U;
         }
+
+        continue;
       }
-      /*------------------------------------------------
-      Function returns "0" on success, and "1" on error.
-      "blockLength" is the true recipient variable
-      pertaining to the function's implicit descriptor.
-      ------------------------------------------------*/
-      if ( getBlockLength( srcbuf, position, magic, &blockLength ) == 0 )
+
+      if ( at.operations >= 0 )
       {
-        writeSLI( srcbuf, &position, blockLength,
-                  &hits, fourCC, magic,
-                  gameID, gameName, path );
+        u32 *stream = (split->magic == Yay) ? &at.poly : &at.defs;
+        u32 displacement = _peek16( block, *stream, 0 );
+        u32 distance = (displacement & 0x0FFFU) + 1U;
+        u32 length;
+        u32 from;
 
-        if ( position == 0 )
+        *stream += 2U;
+        length = ((displacement >> 12) == 0) ?
+                 ((u32)block[at.defs++] + 18U) : ((displacement >> 12) + 2U);
+
+        if ( length > (end - at.out) )
         {
-          return;
+          length = end - at.out;
         }
-      }
-      else
-      {
-        ++oddities;
 
-        if ( options.verbose != 0 )
+        if ( distance > at.out )
         {
-          postDiscrepancy( srcbuf, position, oddities );
+          piece->isFailed = 1;
+          break;
         }
 
-        position += 4U;
-      }
-    }
-    else
-    {
-      if ( magic == CMPR )
-      {
-        magic = _swap32(*(u32 *)&srcbuf[position + 0x10U]);
+        from = at.out - distance;
 
-        if ( magic == SMSR )
+        if (    (distance > (at.out - start))
+             || _isDeferred( piece, from,
+                             ((from + length) < at.out) ?
+                             (from + length) : at.out ) )
         {
-          blockLength = _swap32(*(u32 *)&srcbuf[position + 0x04U]);
-          writeSLI( srcbuf, &position, blockLength,
-                    &hits, fourCC, magic,
-                    gameID, gameName, path );
+          if ( _deferCopy( piece, at.out, distance, length ) != 0 )
+          {
+            piece->isFailed = 1;
+            break;
+          }
 
-          if ( position == 0 )
+          at.out += length;
+        }
+        else
+        {
+          while ( length-- != 0 )
           {
-            return;
+            dst[at.out] = dst[at.out - distance];
+            ++at.out;
           }
         }
       }
       else
       {
-next:   ++position;
+        dst[at.out++] = block[at.defs++];
       }
+
+      at.operations = (i32)((u32)at.operations << 1);
+      --at.masks;
     }
   }
 
-  printf( "# Hits: %u\n# Oddities: %u\n", hits, oddities );
-  return;
+  return (void *)0;
 }
 
 
 
-static void  _usage( void );
-static char *_processArgs();
-static int   _closeROM();
-static void  _getPath();
-static void  _orderBytes();
-static int   _writeROM();
+/*-------------------------------------------------------------------
+Returns 0 once "dst" holds all "sizeDecoded" bytes of "block", and 1
+for the serial path to be taken instead, with nothing of it lost.
+-------------------------------------------------------------------*/
+static int _decodeSplit( const u8 *block, u8 *dst, const u32 magic,
+                         const u32 sizeDecoded )
+{
+  pthread_t workers[THREADS_MAX];
+  struct split split;
+  struct checkpoint at;
+  u32 length = sizeDecoded / (threads << 2);
+  u32 next;
+  u32 started = 0;
+  u32 k;
+  int code = 0;
+
+  memset( &at, 0, sizeof(at) );
+
+  if ( magic == Yay )
+  {
+    at.flags = 0x10U;
+    at.poly  = _peek32( block, 0x08U, 0 );
+    at.defs  = _peek32( block, 0x0CU, 0 );
+
+    if ( (at.poly == 0) || (at.defs < at.poly) )
+    {
+      return 1;
+    }
+  }
+  else
+  {
+    if (    (_peek32( block, 0x08U, 0 ) != 0)
+         || (_peek32( block, 0x0CU, 0 ) != 0) )
+    {
+      return 1;
+    }
+
+    at.defs = 0x10U;
+  }
 
+  length = (length > SPLIT_PIECE) ? length : SPLIT_PIECE;
+  split.block = block;
+  split.dst   = dst;
+  split.magic = magic;
+  split.count = 0;
+  split.next  = 0;
+  split.checkpoints = (struct checkpoint *)
+                      malloc( sizeof(struct checkpoint) *
+                              ((sizeDecoded / length) + 2U) );
+  split.pieces = (struct piece *)calloc( (sizeDecoded / length) + 1U,
+                                         sizeof(struct piece) );
+
+  if (    (split.checkpoints == (struct checkpoint *)0)
+       || (split.pieces == (struct piece *)0) )
+  {
+    free( split.checkpoints );
+    free( split.pieces );
+    return 1;
+  }
 
+  /*-----------------------------------------------------------
+  Checkpoints are only ever taken between tokens, and so where
+  a piece ends is exactly where the next one starts.
+  -----------------------------------------------------------*/
+  next = 0;
 
-int main( const int argc, const char *argv[] )
-{
-  if ( argc < 2 )
+  while ( at.out < sizeDecoded )
   {
-    _usage();
-    return EXIT_FAILURE;
+    if ( at.out >= next )
+    {
+      split.checkpoints[split.count++] = at;
+
+      while ( next <= at.out )
+      {
+        next += length;
+      }
+    }
+
+    if ( at.masks == 0 )
+    {
+      if ( magic == Yay )
+      {
+        at.operations = (i32)_peek32( block, at.flags, 0 );
+        at.masks  = 32U;
+        at.flags += 4U;
+      }
+      else
+      {
+        at.operations = (i32)((u32)block[at.defs++] << 24);
+        at.masks = 8U;
+      }
+
+      continue;
+    }
+
+    if ( at.operations >= 0 )
+    {
+      u32 *stream = (magic == Yay) ? &at.poly : &at.defs;
+      u32 displacement = _peek16( block, *stream, 0 );
+
+      *stream += 2U;
+      at.out  += ((displacement >> 12) == 0) ?
+                 ((u32)block[at.defs++] + 18U) : ((displacement >> 12) + 2U);
+    }
+    else
+    {
+      ++at.defs;
+      ++at.out;
+    }
+
+    at.operations = (i32)((u32)at.operations << 1);
+    --at.masks;
   }
-  else
+
+  split.checkpoints[split.count].out = sizeDecoded;
+
+  while (    (started < (threads - 1U)) && (started < split.count)
+          && (pthread_create( &workers[started], (const pthread_attr_t *)0,
+                              _fillPieces, &split ) == 0) )
+  {
+    ++started;
+  }
+
+  _fillPieces( &split );
+
+  while ( started != 0 )
+  {
+    pthread_join( workers[--started], (void **)0 );
+  }
+
+  for ( k = 0; k < split.count; ++k )
+  {
+    code |= (int)split.pieces[k].isFailed;
+  }
+
+  /*-------------------------------------------------------
+  Pieces put off only what reaches back, so going through
+  them from the first, the bytes copied are always final.
+  -------------------------------------------------------*/
+  for ( k = 0; (k < split.count) && (code == 0); ++k )
+  {
+    const struct piece *piece = &split.pieces[k];
+    u32 i;
+
+    for ( i = 0; i < piece->count; ++i )
+    {
+      const struct deferral *deferral = &piece->deferrals[i];
+      u32 out    = deferral->out;
+      u32 length = deferral->length;
+
+      while ( length-- != 0 )
+      {
+        dst[out] = dst[out - deferral->distance];
+        ++out;
+      }
+    }
+  }
+
+  for ( k = 0; k < split.count; ++k )
   {
-    char  pathROM[PPATH_MAX];
-    char  cdirROM[PPATH_MAX];
-    char *path = (char *)0;
-    FILE *ROM  = (FILE *)0;
+    free( split.pieces[k].deferrals );
+  }
+
+  free( split.pieces );
+  free( split.checkpoints );
+  return code;
+}
+#endif
+
+
+
+/*-------------------------------------------------------------------
+"*dst" is the caller's buffer of at least "sizeDecoded" bytes, every
+one of which is written; it is set to NULL if the data can't be
+decoded.
+-------------------------------------------------------------------*/
+static void decbuf( const u8 *srcbuf, u8 **dst, const u32 position,
+                    const u32 magic, const u32 sizeDecoded )
+{
+  u8 *dest;
+  u8 *previous;
+  u32 masks = 0;
+  u32 flags = 0;
+  /*--------------------------------------------------------------------
+  Position for Polymorphic variables.
+  For MIO0/SMSR00, a half-word contains length-displacement information.
+  For Yay0/Yaz0, a half-word contains the former, however, a nibble
+  with a value of 0 serves as a flag to utilize a byte from "defs" for
+  supplemental length values.
+  --------------------------------------------------------------------*/
+  u32 poly  = 0;
+  /*---------------------------------------------------------------------
+  Position for Definitive variables.
+  For MIO0/SMSR00, this is simply for literal byte copies.
+  For Yay0/Yaz0, it is either the former, or a supplementary length byte.
+  With Yay0, "defs" is within the designated partition.
+  With Yaz0, "defs" represents the entirety of the encoded block.
+  ---------------------------------------------------------------------*/
+  u32 defs  = 0;
+  u32 displacement;
+  i32 operations;
+
+  if ( (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU) )
+  {
+    *dst = (u8 *)0;
+    return;
+  }
+
+  if ( *dst == (u8 *)0 )
+  {
+    return;
+  }
+
+#ifdef XSLI_THREADS
+  if (    ((magic == Yay) || (magic == Yaz))
+       && (sizeDecoded >= SPLIT_MIN) && (threads > 1U)
+       && (isSplitting != 0)
+       && (_decodeSplit( &srcbuf[position], *dst, magic, sizeDecoded ) == 0) )
+  {
+    METER_ADD( decoded, sizeDecoded );
+    return;
+  }
+#endif
+  
+  dest = *dst + sizeDecoded;
+
+  if ( magic != Yaz )
+  {
+    if ( magic != SMSR )
+    {
+      poly = _swap32( *(u32 *)&srcbuf[position + 0x08U] );
+      defs = _swap32( *(u32 *)&srcbuf[position + 0x0CU] );
+
+      if ( (poly == 0) || (defs < poly) )
+      {
+        *dst = (u8 *)0;
+        return;
+      }
+
+      poly += position;
+      defs += position;
+      flags = position + 0x10U;
+    }
+    else
+    {
+      defs = _swap32( *(u32 *)&srcbuf[position + 0x1CU] );
+
+      if ( defs == 0 )
+      {
+        *dst = (u8 *)0;
+        return;
+      }
+
+      defs += position + 0x20U;
+      poly  = position + 0x20U;
+    }
+  }
+  else
+  {
+    if (    (_swap32( *(u32 *)&srcbuf[position + 0x08U] ) != 0)
+         || (_swap32( *(u32 *)&srcbuf[position + 0x0CU] ) != 0) )
+    {
+      *dst = (u8 *)0;
+      return;
+    }
+
+    defs = position + 0x10U;
+  }
+
+  do
+  {
+    if ( masks == 0 )
+    {
+      if ( magic != Yaz )
+      {
+        if ( magic != SMSR )
+        {
+          operations = (i32)_swap32( *(u32 *)&srcbuf[flags] );
+          masks  = 32U;
+          flags += 4U;
+        }
+        else
+        {
+          operations = (i32)_swap16( *(u16 *)&srcbuf[poly] );
+          operations <<= 0x10;
+          masks = 16U;
+          poly += 2U;
+        }
+      }
+      else
+      {
+        operations   = (i32)srcbuf[defs++];
+        operations <<= 0x18;
+        masks = 8U;
+      }
+    }
+    else
+    {
+      if ( operations >= 0 )
+      {
+        displacement = (u32)_swap16( *(u16 *)((magic != Yaz) ?
+                                              &srcbuf[poly]  :
+                                              &srcbuf[defs]) );
+        previous = *dst - ((displacement & 0x00000FFFU) + 1U);
+
+        if ( magic != Yaz )
+        {
+          poly += 2U;
+        }
+        else
+        {
+          defs += 2U;
+        }
+
+        if (    ((displacement >> 12) == 0)
+             && (magic != MIO)
+             && (magic != SMSR) )
+        {
+          displacement = (u32)srcbuf[defs++] + 18U;
+        }
+        else
+        {
+          displacement = (displacement >> 12) + 2U;
+
+          if ( (magic == MIO) || (magic == SMSR) )
+          {
+            ++displacement;
+          }
+        }
+
+        while ( *(*dst)++ = *previous++, --displacement );
+      }
+      else
+      {
+        *(*dst)++ = srcbuf[defs++];
+      }
+
+      operations <<= 1;
+      --masks;
+    }
+  }
+  while ( *dst < dest );
+  
+  *dst -= sizeDecoded;
+  METER_ADD( decoded, sizeDecoded );
+
+  return;
+}
+
+
+
+#ifdef XSLI_ZEROCOPY
+/*--------------------------------------------------------------------
+Copies "length" bytes at "offset" of the ROM file to the end of "SLI"
+without them passing through this process; "copy_file_range" may even
+share the extents on file systems with reflinks [XFS, Btrfs].
+"sendfile" is tried when it isn't supported between the two files.
+Returns how many bytes were copied, leaving the rest to the caller.
+--------------------------------------------------------------------*/
+static u32 _copyRange( const int fdROM, FILE *SLI,
+                       const u32 offset, const u32 length )
+{
+  const int fdSLI = fileno( SLI );
+  loff_t  from = (loff_t)offset;
+  u32     done = 0;
+  ssize_t size;
+
+  while ( done < length )
+  {
+    size = copy_file_range( fdROM, &from, fdSLI, (loff_t *)0,
+                            (size_t)(length - done), 0 );
+
+    if ( size <= 0 )
+    {
+      break;
+    }
+
+    done += (u32)size;
+  }
+
+  if ( done < length )
+  {
+    off_t fromSend = (off_t)(offset + done);
+
+    while ( done < length )
+    {
+      size = sendfile( fdSLI, fdROM, &fromSend, (size_t)(length - done) );
+
+      if ( size <= 0 )
+      {
+        break;
+      }
+
+      done += (u32)size;
+    }
+  }
+
+  return done;
+}
+
+
+
+/*--------------------------------------------------------------------
+Decoded data of "MAP_MIN" bytes or more is decoded straight into its
+file, mapped once it has been given its full length, rather than into
+a buffer that is then written out; "fallocate" reserves the blocks up
+front, so that a full disk fails here and not by a SIGBUS mid-decode.
+Returns NULL if it can't be mapped, or the file system can't reserve
+them, for the caller to write the file as usual. Callers "msync" the
+map before taking the file as written, for errors that only show on
+writeback.
+--------------------------------------------------------------------*/
+#define MAP_MIN 0x10000
+
+static u8 *_mapDecoded( FILE *DECODED, const u32 sizeDecoded )
+{
+  const int fdDecoded = fileno( DECODED );
+  void *map;
+
+  if ( fallocate( fdDecoded, 0, 0, (off_t)sizeDecoded ) != 0 )
+  {
+    return (u8 *)0;
+  }
+
+  map = mmap( (void *)0, (size_t)sizeDecoded, PROT_READ | PROT_WRITE,
+              MAP_SHARED, fdDecoded, 0 );
+
+  return (map != MAP_FAILED) ? (u8 *)map : (u8 *)0;
+}
+#endif
+
+
+
+/*---------------------------------------------------------------------
+"-w" writes MIO0, Yay0 and Yaz0 blocks in another of those formats,
+without decoding them: each token read from the block is written back
+out in the layout of the other. All three have the same tokens, save
+for the lengths of matches, of 3 to 18 for MIO0 and 3 to 273 for Yay0
+and Yaz0, so a match too long for the target is split into ones that
+aren't. Going the other way, back to back matches of one distance are
+joined, where the target allows them to be longer.
+---------------------------------------------------------------------*/
+enum
+{
+  CODE_NONE,
+  CODE_MIO,
+  CODE_YAY,
+  CODE_YAZ
+};
+
+static const u32 codeMagics[4] = { 0, MIO, Yay, Yaz };
+
+struct coder
+{
+  u32 magic;
+  u8 *out;
+  /*------------------------------------------------------------
+  MIO0/Yay0 are written with flags, back-references and bytes
+  in their own areas of "out", put back to back once complete.
+  Yaz0 is written at "defs" alone, with "group" its flag byte.
+  ------------------------------------------------------------*/
+  u32 flags;
+  u32 poly;
+  u32 defs;
+  u32 group;
+  u32 bits;
+  u32 word;
+};
+
+
+
+static void _putFlag( struct coder *coder, const unsigned isLiteral )
+{
+  if ( coder->magic == Yaz )
+  {
+    if ( coder->bits == 0 )
+    {
+      coder->group = coder->defs++;
+      coder->out[coder->group] = 0;
+    }
+
+    coder->out[coder->group] |= (u8)((isLiteral != 0) << (7U - coder->bits));
+    coder->bits = (coder->bits + 1U) & 7U;
+    return;
+  }
+
+  coder->word |= (u32)(isLiteral != 0) << (31U - coder->bits);
+
+  if ( ++coder->bits == 32U )
+  {
+    *(u32 *)&coder->out[coder->flags] = _swap32( coder->word );
+    coder->flags += 4U;
+    coder->bits   = 0;
+    coder->word   = 0;
+  }
+
+  return;
+}
+
+
+
+static void _putMatch( struct coder *coder, u32 length, const u32 distance )
+{
+  u32 most = (coder->magic == MIO) ? 18U : 273U;
+
+  while ( length != 0 )
+  {
+    u32 take = length;
+    u32 code;
+    u32 *stream;
+
+    if ( take > most )
+    {
+      take = ((length - most) >= 3U) ? most : (length - 3U);
+    }
+
+    _putFlag( coder, 0 );
+
+    if ( coder->magic == MIO )
+    {
+      code = ((take - 3U) << 12) | (distance - 1U);
+    }
+    else
+    {
+      code = ((take >= 18U) ? 0 : ((take - 2U) << 12)) | (distance - 1U);
+    }
+
+    stream = (coder->magic == Yaz) ? &coder->defs : &coder->poly;
+    coder->out[(*stream)++] = (u8)(code >> 8);
+    coder->out[(*stream)++] = (u8)code;
+
+    if ( (coder->magic != MIO) && (take >= 18U) )
+    {
+      coder->out[coder->defs++] = (u8)(take - 18U);
+    }
+
+    length -= take;
+  }
+
+  return;
+}
+
+
+
+/*-------------------------------------------------------------------
+Returns the block transcoded to "target" in the pool's buffer for
+"depth", or NULL if it can't be read in full within "blockLength".
+-------------------------------------------------------------------*/
+static u8 *_transcode( const u8 *block, const u32 blockLength,
+                       const u32 magic, const u32 target,
+                       struct pool *pool, const u32 depth,
+                       u32 *codedLength )
+{
+  struct coder coder;
+  u32 sizeDecoded;
+  u32 written = 0;
+  u32 masks   = 0;
+  u32 flags   = 0x10U;
+  u32 poly    = 0;
+  u32 defs    = 0x10U;
+  u32 polyEnd = blockLength;
+  u32 flagsEnd = 0;
+  u32 pending = 0;
+  u32 pendingDistance = 0;
+  u32 flagsMax;
+  u32 polyMax;
+  i32 operations = 0;
+  unsigned isJoined = (magic == MIO) && (target != MIO);
+
+  if ( blockLength < 0x10U )
+  {
+    return (u8 *)0;
+  }
+
+  sizeDecoded = _peek32( block, 0x04U, 0 );
+
+  if ( (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU) )
+  {
+    return (u8 *)0;
+  }
+
+  if ( magic != Yaz )
+  {
+    poly = _peek32( block, 0x08U, 0 );
+    defs = _peek32( block, 0x0CU, 0 );
+
+    if ( (poly < 0x10U) || (defs < poly) || (defs > blockLength) )
+    {
+      return (u8 *)0;
+    }
+
+    flagsEnd = poly;
+    polyEnd  = defs;
+  }
+
+  /*--------------------------------------------------------------
+  Every token is at least a byte of output, and every match of
+  3 bytes or more takes at most 3 bytes to write, which bounds
+  each area by "sizeDecoded", the flags by one bit per token.
+  --------------------------------------------------------------*/
+  flagsMax = ((sizeDecoded >> 3) + 8U) & ~3U;
+  polyMax  = ((sizeDecoded / 3U) << 1) + 4U;
+  memset( &coder, 0, sizeof(coder) );
+  coder.magic = target;
+  coder.out   = (u8 *)_poolGet( pool, POOL_CODED, depth,
+                                0x10U + flagsMax + polyMax + sizeDecoded );
+
+  if ( coder.out == (u8 *)0 )
+  {
+    return (u8 *)0;
+  }
+
+  coder.flags = 0x10U;
+  coder.poly  = 0x10U + flagsMax;
+  coder.defs  = (target == Yaz) ? 0x10U : (coder.poly + polyMax);
+
+  while ( written < sizeDecoded )
+  {
+    if ( masks == 0 )
+    {
+      if ( magic == Yaz )
+      {
+        if ( defs >= blockLength )
+        {
+          return (u8 *)0;
+        }
+
+        operations = (i32)((u32)block[defs++] << 24);
+        masks = 8U;
+      }
+      else
+      {
+        if ( (flags + 4U) > flagsEnd )
+        {
+          return (u8 *)0;
+        }
+
+        operations = (i32)_peek32( block, flags, 0 );
+        masks  = 32U;
+        flags += 4U;
+      }
+
+      continue;
+    }
+
+    if ( operations >= 0 )
+    {
+      u32 *stream = (magic == Yaz) ? &defs : &poly;
+      u32 displacement;
+      u32 length;
+
+      if ( (*stream + 2U) > ((magic == Yaz) ? blockLength : polyEnd) )
+      {
+        return (u8 *)0;
+      }
+
+      displacement = _peek16( block, *stream, 0 );
+      *stream += 2U;
+
+      if ( (displacement & 0x0FFFU) >= written )
+      {
+        return (u8 *)0;
+      }
+
+      if ( magic == MIO )
+      {
+        length = (displacement >> 12) + 3U;
+      }
+      else if ( (displacement >> 12) == 0 )
+      {
+        if ( defs >= blockLength )
+        {
+          return (u8 *)0;
+        }
+
+        length = (u32)block[defs++] + 18U;
+      }
+      else
+      {
+        length = (displacement >> 12) + 2U;
+      }
+
+      if ( length > (sizeDecoded - written) )
+      {
+        return (u8 *)0;
+      }
+
+      displacement = (displacement & 0x0FFFU) + 1U;
+
+      if ( (pending != 0) && (displacement != pendingDistance) )
+      {
+        _putMatch( &coder, pending, pendingDistance );
+        pending = 0;
+      }
+
+      if ( isJoined != 0 )
+      {
+        pending        += length;
+        pendingDistance = displacement;
+      }
+      else
+      {
+        _putMatch( &coder, length, displacement );
+      }
+
+      written += length;
+    }
+    else
+    {
+      if ( defs >= blockLength )
+      {
+        return (u8 *)0;
+      }
+
+      if ( pending != 0 )
+      {
+        _putMatch( &coder, pending, pendingDistance );
+        pending = 0;
+      }
+
+      _putFlag( &coder, 1 );
+      coder.out[coder.defs++] = block[defs++];
+      ++written;
+    }
+
+    operations = (i32)((u32)operations << 1);
+    --masks;
+  }
+
+  if ( pending != 0 )
+  {
+    _putMatch( &coder, pending, pendingDistance );
+  }
+
+  *(u32 *)&coder.out[0x00U] = _swap32( target );
+  *(u32 *)&coder.out[0x04U] = _swap32( sizeDecoded );
+
+  if ( target == Yaz )
+  {
+    *(u32 *)&coder.out[0x08U] = 0;
+    *(u32 *)&coder.out[0x0CU] = 0;
+    *codedLength = coder.defs;
+    return coder.out;
+  }
+
+  if ( coder.bits != 0 )
+  {
+    *(u32 *)&coder.out[coder.flags] = _swap32( coder.word );
+    coder.flags += 4U;
+  }
+
+  /*-----------------------------------------------------
+  The areas close up: back-references after the flags,
+  then the bytes, as "getBlockLength" measures them.
+  -----------------------------------------------------*/
+  {
+    u32 polyStart = 0x10U + flagsMax;
+    u32 defsStart = polyStart + polyMax;
+    u32 polyLength = coder.poly - polyStart;
+    u32 defsLength = coder.defs - defsStart;
+
+    memmove( &coder.out[coder.flags], &coder.out[polyStart], polyLength );
+    memmove( &coder.out[coder.flags + polyLength], &coder.out[defsStart],
+             defsLength );
+    *(u32 *)&coder.out[0x08U] = _swap32( coder.flags );
+    *(u32 *)&coder.out[0x0CU] = _swap32( coder.flags + polyLength );
+    *codedLength = coder.flags + polyLength + defsLength;
+  }
+
+  return coder.out;
+}
+
+
+
+/*---------------------------------------------------------------------
+"-h" keeps an index of the blocks decoded from every ROM, across runs,
+for "--find" to tell which ROMs hold an asset, or one much like it.
+Every field is a Big-Endian u32; after "XSLI" "SIM1" come records of a
+kind, the length of what follows it, and that many bytes:
+
+  "ROM " : LENGTH, CRC32, PATH
+  "BLK " : OFFSET, DEPTH, FORMAT, RAW, DECODED, CRC32, FNV-1a,
+           SKETCH[SKETCH_BINS], NAME
+
+with the strings NUL-terminated and padded out to 32 bits. The index
+only ever grows: a ROM is added again once its length or CRC32 (of its
+bytes in Big-Endian order) change, and only its newest records count.
+
+SKETCH is a one-permutation MinHash of the 8-byte shingles of the data
+decoded: the hash of each shingle picks a bin by its top bits, which
+keeps the least hash to fall into it. The share of the bins that two
+blocks agree in estimates the Jaccard similarity of their shingles.
+---------------------------------------------------------------------*/
+#define INDEX_MAGIC   0x58534C49  /* "XSLI" */
+#define INDEX_VERSION 0x53494D31  /* "SIM1" */
+#define INDEX_ROM     0x524F4D20  /* "ROM " */
+#define INDEX_BLOCK   0x424C4B20  /* "BLK " */
+#define INDEX_FIELDS  7
+#define SKETCH_BINS   32
+#define SKETCH_SHIFT  27
+#define SKETCH_EMPTY  0xFFFFFFFFU
+#define SKETCH_NEAR   0.5         /* Least similarity reported */
+#define SHINGLE       8U
+#define SHINGLE_BASE  0x9E3779B1U
+
+struct indexedROM
+{
+  char *path;
+  u32 length;
+  u32 crc;
+  u32 at;             /* Of its record, as last loaded */
+  unsigned isLive;    /* Not superseded by a later record */
+};
+
+static struct
+{
+  const char *path;
+  const char *query;  /* "--find" */
+  FILE *INDEX;
+  struct indexedROM *ROMs;
+  u32 countROMs;
+  u32 maxROMs;
+  /*-------------------------------------------------------------
+  Length of the directory leading the names given to the index,
+  which is dropped, and the blocks added for the current ROM.
+  -------------------------------------------------------------*/
+  size_t prefix;
+  u32 blocks;
+  unsigned isAdding;
+  unsigned isFailed;
+}
+similarity;
+
+
+
+static u32 _mixHash( u32 hash )
+{
+  hash ^= hash >> 16;
+  hash *= 0x85EBCA6BU;
+  hash ^= hash >> 13;
+  hash *= 0xC2B2AE35U;
+  hash ^= hash >> 16;
+  return hash;
+}
+
+
+
+static void _sketchData( const u8 *data, const u32 length,
+                         u32 *sketch, u32 *fnv )
+{
+  register u32 rolling = 0;
+  register u32 i;
+  u32 power = 1;
+
+  for ( i = 0; i < SHINGLE; ++i )
+  {
+    power *= SHINGLE_BASE;
+  }
+
+  for ( i = 0; i < SKETCH_BINS; ++i )
+  {
+    sketch[i] = SKETCH_EMPTY;
+  }
+
+  *fnv = 0x811C9DC5U;
+
+  for ( i = 0; i < length; ++i )
+  {
+    *fnv    = (*fnv ^ data[i]) * 0x01000193U;
+    rolling = (rolling * SHINGLE_BASE) + data[i];
+
+    if ( i >= SHINGLE )
+    {
+      rolling -= power * data[i - SHINGLE];
+    }
+
+    if ( i >= (SHINGLE - 1U) )
+    {
+      u32 hash = _mixHash( rolling );
+      u32 *bin = &sketch[hash >> SKETCH_SHIFT];
+
+      if ( hash < *bin )
+      {
+        *bin = hash;
+      }
+    }
+  }
+
+  return;
+}
+
+
+
+static double _getSimilarity( const u32 *a, const u32 *b )
+{
+  u32 agreed = 0;
+  u32 used   = 0;
+  u32 i;
+
+  for ( i = 0; i < SKETCH_BINS; ++i )
+  {
+    if ( (a[i] != SKETCH_EMPTY) || (b[i] != SKETCH_EMPTY) )
+    {
+      ++used;
+      agreed += (a[i] == b[i]);
+    }
+  }
+
+  return (used != 0) ? ((double)agreed / used) : 0.0;
+}
+
+
+
+static int _putRecord( const u32 kind, const u32 *fields, const u32 count,
+                       const char *text, const size_t length )
+{
+  static const char zeroes[4] = { 0, 0, 0, 0 };
+  u32 words[2 + INDEX_FIELDS + SKETCH_BINS];
+  size_t padded = (length + 4U) & ~(size_t)3U;
+  u32 i;
+
+  words[0] = _swap32( kind );
+  words[1] = _swap32( (u32)((count << 2) + padded) );
+
+  for ( i = 0; i < count; ++i )
+  {
+    words[2 + i] = _swap32( fields[i] );
+  }
+
+  return    (fwrite( words, sizeof(u32), 2 + count, similarity.INDEX )
+             != (2 + count))
+         || (fwrite( text, sizeof(char), length, similarity.INDEX )
+             != length)
+         || (fwrite( zeroes, sizeof(char), padded - length,
+                     similarity.INDEX ) != (padded - length));
+}
+
+
+
+/*-----------------------------------------------------------------
+The record at "*at" of "data", after which "*at" is moved; null at
+the end, or where a record runs past it, unaligned or unterminated.
+-----------------------------------------------------------------*/
+static const u8 *_getRecord( const u8 *data, const u32 length, u32 *at,
+                             u32 *kind, u32 *size )
+{
+  const u8 *record;
+
+  if ( (length - *at) < 8U )
+  {
+    return (const u8 *)0;
+  }
+
+  *kind = _swap32( *(u32 *)&data[*at] );
+  *size = _swap32( *(u32 *)&data[*at + 4U] );
+
+  if (    ((*size & 3U) != 0) || (*size < 4U)
+       || (*size > (length - *at - 8U))
+       || (data[*at + 8U + *size - 1U] != '\0') )
+  {
+    return (const u8 *)0;
+  }
+
+  record = &data[*at + 8U];
+  *at   += 8U + *size;
+  return record;
+}
+
+
+
+static int _noteROM( const char *path, const u32 length, const u32 crc,
+                     const u32 at )
+{
+  struct indexedROM *ROM;
+  u32 i;
+
+  if ( similarity.countROMs == similarity.maxROMs )
+  {
+    u32 most = (similarity.maxROMs != 0) ? (similarity.maxROMs << 1) : 64U;
+    struct indexedROM *ROMs = (struct indexedROM *)
+                              realloc( similarity.ROMs,
+                                       most * sizeof(struct indexedROM) );
+
+    if ( ROMs == (struct indexedROM *)0 )
+    {
+      return 1;
+    }
+
+    similarity.ROMs    = ROMs;
+    similarity.maxROMs = most;
+  }
+
+  ROM = &similarity.ROMs[similarity.countROMs];
+
+  if ( (ROM->path = (char *)malloc( strlen( path ) + 1U )) == (char *)0 )
+  {
+    return 1;
+  }
+
+  for ( i = 0; i < similarity.countROMs; ++i )
+  {
+    if ( strcmp( similarity.ROMs[i].path, path ) == 0 )
+    {
+      similarity.ROMs[i].isLive = 0;
+    }
+  }
+
+  strcpy( ROM->path, path );
+  ROM->length = length;
+  ROM->crc    = crc;
+  ROM->at     = at;
+  ROM->isLive = 1;
+  similarity.countROMs++;
+  return 0;
+}
+
+
+
+static void _forgetROMs( void )
+{
+  while ( similarity.countROMs != 0 )
+  {
+    free( similarity.ROMs[--similarity.countROMs].path );
+  }
+
+  return;
+}
+
+
+
+/*---------------------------------------------------------------
+Reads the whole index into memory, noting each ROM record in it;
+the caller frees what is returned, and null is an error, told of.
+---------------------------------------------------------------*/
+static u8 *_loadIndex( u32 *length )
+{
+  u8 *data;
+  long size;
+  u32 at   = 8U;
+  u32 last = 8U;
+  u32 kind;
+  u32 recordSize;
+  const u8 *record;
+
+  if (    (fseek( similarity.INDEX, 0, SEEK_END ) != 0)
+       || ((size = ftell( similarity.INDEX )) < 0)
+       || (size > 0x7FFFFFFFL)
+       || (fseek( similarity.INDEX, 0, SEEK_SET ) != 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to read the index!\n\n" );
+    return (u8 *)0;
+  }
+
+  if ( (data = (u8 *)malloc( (size_t)size + 1U )) == (u8 *)0 )
+  {
+    fprintf( STATUS,
+             "\n>>> Unable to allocate work RAM for the index!\n\n" );
+    return (u8 *)0;
+  }
+
+  *length = (u32)size;
+
+  if ( fread( data, sizeof(u8), *length, similarity.INDEX ) != *length )
+  {
+    fprintf( STATUS, "\n>>> Unable to read the index!\n\n" );
+    goto err;
+  }
+
+  if ( *length == 0 )
+  {
+    return data;
+  }
+
+  if (    (*length < 8U)
+       || (_swap32( *(u32 *)&data[0] ) != INDEX_MAGIC)
+       || (_swap32( *(u32 *)&data[4] ) != INDEX_VERSION) )
+  {
+    fprintf( STATUS, "\n>>> Not an index: \"%s\"\n\n", similarity.path );
+    goto err;
+  }
+
+  while ( (record = _getRecord( data, *length, &at,
+                                &kind, &recordSize )) != (const u8 *)0 )
+  {
+    if ( kind == INDEX_ROM )
+    {
+      last = (u32)(record - data) - 8U;
+    }
+  }
+
+  /*--------------------------------------------------------------
+  A record torn by a run that was cut short is dropped, with the
+  ROM it was part of, whose blocks may not all have been added, so
+  that it is indexed again; "_openIndex" cuts the file to match.
+  --------------------------------------------------------------*/
+  if ( at != *length )
+  {
+    fprintf( STATUS, "# Index damaged at 0x%X, dropping from 0x%X.\n",
+                     at, last );
+    *length = last;
+  }
+
+  at = 8U;
+  _forgetROMs();
+
+  while ( (record = _getRecord( data, *length, &at,
+                                &kind, &recordSize )) != (const u8 *)0 )
+  {
+    if (    (kind == INDEX_ROM) && (recordSize > 8U)
+         && (_noteROM( (const char *)&record[8],
+                       _swap32( *(u32 *)&record[0] ),
+                       _swap32( *(u32 *)&record[4] ),
+                       (u32)(record - data) - 8U ) != 0) )
+    {
+      fprintf( STATUS,
+               "\n>>> Unable to allocate work RAM for the index!\n\n" );
+      goto err;
+    }
+  }
+
+  return data;
+
+err:
+  free( data );
+  return (u8 *)0;
+}
+
+
+
+static int _openIndex( const unsigned isAdding )
+{
+  u8 *data;
+  u32 length;
+  long end;
+
+  similarity.INDEX = fopen( similarity.path,
+                            (isAdding != 0) ? "a+b" : "rb" );
+
+  if ( similarity.INDEX == (FILE *)0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to open the index!\n\n" );
+    return EXIT_FAILURE;
+  }
+
+  if ( (data = _loadIndex( &length )) == (u8 *)0 )
+  {
+    return EXIT_FAILURE;
+  }
+
+  free( data );
+
+  if (    (fseek( similarity.INDEX, 0, SEEK_END ) != 0)
+       || ((end = ftell( similarity.INDEX )) < 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to read the index!\n\n" );
+    return EXIT_FAILURE;
+  }
+
+  if ( (isAdding != 0) && ((u32)end != length) )
+  {
+#ifdef XSLI_ZEROCOPY
+    if (    (fflush( similarity.INDEX ) != 0)
+         || (ftruncate( fileno( similarity.INDEX ), (off_t)length ) != 0)
+         || (fseek( similarity.INDEX, 0, SEEK_END ) != 0) )
+#endif
+    {
+      fprintf( STATUS, "\n>>> Unable to repair the index!\n\n" );
+      return EXIT_FAILURE;
+    }
+  }
+
+  if ( length == 0 )
+  {
+    u32 header[2];
+
+    header[0] = _swap32( INDEX_MAGIC );
+    header[1] = _swap32( INDEX_VERSION );
+
+    if (    (isAdding == 0)
+         || (fwrite( header, sizeof(u32), 2, similarity.INDEX ) != 2) )
+    {
+      fprintf( STATUS, "\n>>> Unable to write the index!\n\n" );
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+
+static int _closeIndex( void )
+{
+  int code = EXIT_SUCCESS;
+
+  if (    (similarity.INDEX != (FILE *)0)
+       && (fclose( similarity.INDEX ) != 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to write the index!\n\n" );
+    code = EXIT_FAILURE;
+  }
+
+  similarity.INDEX = (FILE *)0;
+  _forgetROMs();
+  free( similarity.ROMs );
+  similarity.ROMs    = (struct indexedROM *)0;
+  similarity.maxROMs = 0;
+  return code;
+}
+
+
+
+/*-----------------------------------------------------------------
+Decides whether the blocks of the ROM at "path" are to be indexed,
+and if so adds a record for it; "prefix" is the length of the path
+before the names of those blocks, as "writeSLI" gives them. Returns
+non-zero where it is indexed unchanged, and needn't be scanned.
+-----------------------------------------------------------------*/
+static int _beginIndex( const char *path, const u8 *srcbuf,
+                         const u32 lengthROM, const u32 xr,
+                         const size_t prefix )
+{
+  u32 fields[2];
+  u32 i = similarity.countROMs;
+
+  fields[0] = lengthROM;
+  fields[1] = _crc32( srcbuf, 0, lengthROM, xr );
+  similarity.prefix   = prefix;
+  similarity.blocks   = 0;
+  similarity.isAdding = 0;
+
+  while ( i-- != 0 )
+  {
+    const struct indexedROM *ROM = &similarity.ROMs[i];
+
+    if ( (ROM->isLive != 0) && (strcmp( ROM->path, path ) == 0) )
+    {
+      if ( (ROM->length == fields[0]) && (ROM->crc == fields[1]) )
+      {
+        fprintf( STATUS, "# Indexed already, as %08X.\n", fields[1] );
+        return 1;
+      }
+
+      break;
+    }
+  }
+
+  if (    (_putRecord( INDEX_ROM, fields, 2, path, strlen( path ) ) != 0)
+       || (_noteROM( path, fields[0], fields[1], 0 ) != 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to write the index!\n\n" );
+    similarity.isFailed = 1;
+    return 0;
+  }
+
+  similarity.isAdding = 1;
+  return 0;
+}
+
+
+
+static void _indexBlock( const char *name, const size_t lengthName,
+                         const u32 position, const u32 depth,
+                         const u32 magic, const u32 blockLength,
+                         const u8 *data, const u32 sizeDecoded )
+{
+  u32 fields[INDEX_FIELDS + SKETCH_BINS];
+
+  if ( similarity.isAdding == 0 )
+  {
+    return;
+  }
+
+  fields[0] = position;
+  fields[1] = depth;
+  fields[2] = _getFormatInfo( magic )->tag;
+  fields[3] = blockLength;
+  fields[4] = sizeDecoded;
+  fields[5] = _crc32( data, 0, sizeDecoded, 0 );
+  _sketchData( data, sizeDecoded, &fields[INDEX_FIELDS], &fields[6] );
+
+  if ( _putRecord( INDEX_BLOCK, fields, INDEX_FIELDS + SKETCH_BINS,
+                   &name[similarity.prefix],
+                   lengthName - similarity.prefix ) != 0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to write the index!\n\n" );
+    similarity.isAdding = 0;
+    similarity.isFailed = 1;
+    return;
+  }
+
+  similarity.blocks++;
+  return;
+}
+
+
+
+static void _endIndex( void )
+{
+  if ( similarity.isAdding != 0 )
+  {
+    fflush( similarity.INDEX );
+    fprintf( STATUS, "# Indexed: %u\n", similarity.blocks );
+    similarity.isAdding = 0;
+  }
+
+  return;
+}
+
+
+
+struct match
+{
+  double similarity;
+  const u8 *record;
+  const char *pathROM;
+};
+
+
+
+static int _compareMatches( const void *a, const void *b )
+{
+  const struct match *x = (const struct match *)a;
+  const struct match *y = (const struct match *)b;
+
+  if ( x->similarity != y->similarity )
+  {
+    return (x->similarity < y->similarity) ? 1 : -1;
+  }
+
+  return (x->record < y->record) ? -1 : (x->record > y->record);
+}
+
+
+
+/*-----------------------------------------------------------------
+"query" is a file of decoded data, or failing that the CRC32 of one
+in hexadecimal. Blocks with the same size and hashes are printed at
+100%, and then those estimated to be at least SKETCH_NEAR alike.
+-----------------------------------------------------------------*/
+static int findSLI( const char *query )
+{
+  u32 sketch[SKETCH_BINS];
+  u32 crc = 0;
+  u32 fnv = 0;
+  u32 size = 0;
+  unsigned isHash = 0;
+  u8 *data;
+  u32 length;
+  struct match *matches = (struct match *)0;
+  u32 countMatches = 0;
+  u32 maxMatches = 0;
+  u32 exact = 0;
+  u32 searched = 0;
+  u32 ROMs = 0;
+  u32 at = 8U;
+  u32 kind;
+  u32 recordSize;
+  const u8 *record;
+  const char *pathROM = (const char *)0;
+  u32 i = 0;
+
+  {
+    FILE *ASSET = fopen( query, "rb" );
+
+    if ( ASSET != (FILE *)0 )
+    {
+      u8 *asset = (u8 *)0;
+      long end;
+
+      if (    (fseek( ASSET, 0, SEEK_END ) != 0)
+           || ((end = ftell( ASSET )) < 0) || (end > 0x7FFFFFFFL)
+           || (fseek( ASSET, 0, SEEK_SET ) != 0)
+           || ((asset = (u8 *)malloc( (size_t)end + 1U )) == (u8 *)0)
+           || (fread( asset, sizeof(u8), (size_t)end, ASSET )
+               != (size_t)end) )
+      {
+        fprintf( STATUS, "\n>>> Unable to read \"%s\"!\n\n", query );
+        free( asset );
+        fclose( ASSET );
+        return EXIT_FAILURE;
+      }
+
+      fclose( ASSET );
+      size = (u32)end;
+      crc  = _crc32( asset, 0, size, 0 );
+      _sketchData( asset, size, sketch, &fnv );
+      free( asset );
+    }
+    else
+    {
+      char *end;
+
+      crc    = (u32)strtoul( query, &end, 16 );
+      isHash = 1;
+
+      if (    (query[0] == '\0') || (*end != '\0')
+           || ((end - query) > 8) || (isxdigit( (u8)query[0] ) == 0) )
+      {
+        fprintf( STATUS, "\n>>> Neither a file nor a CRC32: \"%s\"\n\n",
+                         query );
+        return EXIT_FAILURE;
+      }
+    }
+  }
+
+  if ( (data = _loadIndex( &length )) == (u8 *)0 )
+  {
+    return EXIT_FAILURE;
+  }
+
+  while ( (record = _getRecord( data, length, &at,
+                                &kind, &recordSize )) != (const u8 *)0 )
+  {
+    if ( kind == INDEX_ROM )
+    {
+      /*--------------------------------------------------------
+      ROM records were noted in the order they come in, and are
+      only looked at here in that order too.
+      --------------------------------------------------------*/
+      while ( (i < similarity.countROMs)
+              && (similarity.ROMs[i].at < (u32)(record - data) - 8U) )
+      {
+        ++i;
+      }
+
+      pathROM = (   (i < similarity.countROMs)
+                 && (similarity.ROMs[i].isLive != 0) ) ?
+                similarity.ROMs[i].path : (const char *)0;
+      ROMs   += (pathROM != (const char *)0);
+    }
+    else if (    (kind == INDEX_BLOCK) && (pathROM != (const char *)0)
+              && (recordSize > ((INDEX_FIELDS + SKETCH_BINS) << 2)) )
+    {
+      const u32 *fields = (const u32 *)record;
+      u32 blockSketch[SKETCH_BINS];
+      double alike;
+      u32 j;
+
+      ++searched;
+
+      if ( isHash != 0 )
+      {
+        alike = (_swap32( fields[5] ) == crc) ? 1.0 : 0.0;
+      }
+      else if (    (_swap32( fields[4] ) == size)
+                && (_swap32( fields[5] ) == crc)
+                && (_swap32( fields[6] ) == fnv) )
+      {
+        alike = 1.0;
+      }
+      else
+      {
+        for ( j = 0; j < SKETCH_BINS; ++j )
+        {
+          blockSketch[j] = _swap32( fields[INDEX_FIELDS + j] );
+        }
+
+        alike = _getSimilarity( sketch, blockSketch );
+
+        /*-------------------------------------------------------
+        Agreeing in every bin isn't the same as holding the same
+        bytes, which has been ruled out already.
+        -------------------------------------------------------*/
+        if ( alike >= 1.0 )
+        {
+          alike = 0.9999;
+        }
+      }
+
+      if ( alike < ((isHash != 0) ? 1.0 : SKETCH_NEAR) )
+      {
+        continue;
+      }
+
+      if ( countMatches == maxMatches )
+      {
+        u32 most = (maxMatches != 0) ? (maxMatches << 1) : 64U;
+        struct match *more = (struct match *)
+                             realloc( matches, most * sizeof(struct match) );
+
+        if ( more == (struct match *)0 )
+        {
+          fprintf( STATUS,
+                   "\n>>> Unable to allocate work RAM for matches!\n\n" );
+          free( matches );
+          free( data );
+          return EXIT_FAILURE;
+        }
+
+        matches    = more;
+        maxMatches = most;
+      }
+
+      matches[countMatches].similarity = alike;
+      matches[countMatches].record     = record;
+      matches[countMatches].pathROM    = pathROM;
+      countMatches++;
+      exact += (alike >= 1.0);
+    }
+  }
+
+  if ( countMatches > 1 )
+  {
+    qsort( matches, countMatches, sizeof(struct match), _compareMatches );
+  }
+
+  for ( i = 0; i < countMatches; ++i )
+  {
+    const u32 *fields = (const u32 *)matches[i].record;
+
+    printf( "%6.2f%% %-24s %s %10u  %08X  %s\n",
+            matches[i].similarity * 100.0,
+            (const char *)&fields[INDEX_FIELDS + SKETCH_BINS],
+            _getFormatInfo( _swap32( fields[2] ) )->name,
+            _swap32( fields[4] ), _swap32( fields[5] ),
+            matches[i].pathROM );
+  }
+
+  fprintf( STATUS, "# Exact: %u\n# Similar: %u\n"
+                   "# Searched: %u blocks of %u ROMs\n",
+                   exact, countMatches - exact, searched, ROMs );
+  free( matches );
+  free( data );
+  return EXIT_SUCCESS;
+}
+
+
+
+/*---------------------------------------------------------------
+"block" points at the Big-Endian SLI header of the data found at
+"*position", which need not lie within the scanned buffer itself.
+"isPristine" is set when the block's bytes are exactly those at
+"*position" of the ROM file, so that they may be copied from it.
+---------------------------------------------------------------*/
+static void writeSLI( const u8 *block,
+                      register u32 *position, const u32 blockLength,
+                      struct tally *tally, const u32 fourCC, const u32 magic,
+                      const char *gameID,
+                      const char *gameName,
+                      const char *path, const u32 depth,
+                      const unsigned isPristine )
+{
+  FILE *SLI     = (FILE *)0;
+  FILE *DECODED = (FILE *)0;
+  char *dataEntry   = (char *)_poolGet( tally->pool, POOL_NAME,
+                                        depth, FILENAME_MAX );
+  char *decodedDest = (char *)0;
+  u8   *dst = (u8 *)0;
+  u8   *coded = (u8 *)0;
+  u8   *mapped = (u8 *)0;
+  u32   sizeDecoded = 0;
+  u32   codedLength = 0;
+  u32   kernel = _getFormatInfo( magic )->kernel;
+  size_t lengthName = 0;
+  /*------------------------------------------------------------
+  Decoded data is needed in memory when scanning it recursively,
+  or indexing it, even if it isn't going to be written out.
+  ------------------------------------------------------------*/
+  unsigned toRecurse = (depth < options.maxDepth);
+
+  if ( dataEntry == (char *)0 )
+  {
+    if ( options.verbose != 0 )
+    {
+      fprintf( STATUS, "\n>>> Unable to allocate for file name!\n\n" );
+    }
+
+    goto err;
+  }
+
+  if ( options.toDecode != 0 )
+  {
+    decodedDest = (char *)_poolGet( tally->pool, POOL_DEST,
+                                    depth, FILENAME_MAX );
+
+    if ( decodedDest == (char *)0 )
+    {
+      if ( options.verbose != 0 )
+      {
+        fprintf( STATUS,
+                 "\n>>> Unable to allocate for decoded file name!\n\n" );
+      }
+
+      goto err;
+    }
+  }
+
+  if ( ((fourCC != 0) && (options.useGameName != 0)) )
+  {
+    sprintf( dataEntry, "%s[%s]_%s_[0x%X]",
+             path, gameID, gameName, *position );
+  }
+  else
+  {
+    sprintf( dataEntry, "%s0x%X", path, *position );
+  }
+
+  if ( options.toDecode != 0 )
+  {
+    sprintf( decodedDest, "%s", dataEntry );
+  }
+
+  if (    (options.transcode != 0)
+       && (    (kernel == MIO) || (kernel == Yay) || (kernel == Yaz) )
+       && (magic != codeMagics[options.transcode]) )
+  {
+    coded = _transcode( block, blockLength, kernel,
+                        codeMagics[options.transcode],
+                        tally->pool, depth, &codedLength );
+
+    if ( (coded == (u8 *)0) && (options.verbose != 0) )
+    {
+      fprintf( STATUS, "\n>>> Unable to transcode, writing as is!\n\n" );
+    }
+  }
+
+  lengthName = strlen( dataEntry );
+  strcat( dataEntry, _getFormatInfo( (coded != (u8 *)0) ?
+                                     codeMagics[options.transcode] :
+                                     magic )->extension );
+
+  if ( (SLI = fopen( dataEntry, "wb" )) == (FILE *)0 )
+  {
+    if ( options.verbose != 0 )
+    {
+      fprintf( STATUS, "\n>>> Unable to create SLI file!\n\n" );
+    }
+
+    goto err;
+  }
+
+  if ( options.toDecode != 0 )
+  {
+    /*------------------------------------------------------
+    Opened for reading too, as "_mapDecoded" requires of it.
+    ------------------------------------------------------*/
+    if ( (DECODED = fopen( decodedDest, "w+b" )) == (FILE *)0 )
+    {
+      if ( options.verbose != 0 )
+      {
+        fprintf( STATUS, "\n>>> Unable to create Decoded file!\n\n" );
+      }
+
+      goto err;
+    }
+  }
+
+  if (    (options.toDecode != 0) || (toRecurse != 0)
+       || (similarity.isAdding != 0) )
+  {
+    sizeDecoded = _getDecodedSize( block, magic );
+
+#ifdef XSLI_ZEROCOPY
+    if (    (DECODED != (FILE *)0)
+         && (sizeDecoded >= MAP_MIN) && (sizeDecoded < 0x3FFFFFFFU) )
+    {
+      dst = mapped = _mapDecoded( DECODED, sizeDecoded );
+    }
+
+    if ( dst == (u8 *)0 )
+#endif
+    {
+      dst = (u8 *)_poolGet( tally->pool, POOL_DECODED, depth, sizeDecoded );
+    }
+
+    TRACE_BEGIN( TRACE_DECODE, *position, magic );
+    _decodeBlock( block, &dst, magic, sizeDecoded );
+    TRACE_END( TRACE_DECODE, *position, magic );
+
+    if ( dst == (u8 *)0 )
+    {
+      if ( options.verbose != 0 )
+      {
+        fprintf( STATUS, "\n>>> Unable to decode data segment!\n\n" );
+      }
+
+      goto err;
+    }
+    else
+    {
+      _indexBlock( dataEntry, lengthName, *position, depth, magic,
+                   blockLength, dst, sizeDecoded );
+
+      if ( options.toDecode != 0 )
+      {
+#ifdef XSLI_ZEROCOPY
+        if (    (mapped != (u8 *)0)
+             && (msync( mapped, (size_t)sizeDecoded, MS_SYNC ) != 0) )
+        {
+          if ( options.verbose != 0 )
+          {
+            fprintf( STATUS, "\n>>> Unable to write Decoded file!\n\n" );
+          }
+
+          goto err;
+        }
+#endif
+
+        TRACE_BEGIN( TRACE_WRITE, *position, magic );
+
+        if ( mapped == (u8 *)0 )
+        {
+          fwrite( dst, sizeof(u8), sizeDecoded, DECODED );
+        }
+
+        METER_ADD( written, sizeDecoded );
+        fflush( DECODED );
+        fclose( DECODED );
+        DECODED = (FILE *)0;
+        TRACE_END( TRACE_WRITE, *position, magic );
+      }
+    }
+  }
+
+  TRACE_BEGIN( TRACE_WRITE, *position, magic );
+
+  if ( coded != (u8 *)0 )
+  {
+    fwrite( coded, sizeof(u8), codedLength, SLI );
+  }
+  else
+#ifdef XSLI_ZEROCOPY
+  if ( (isPristine != 0) && (tally->fdROM >= 0) )
+  {
+    u32 done = _copyRange( tally->fdROM, SLI, *position, blockLength );
+
+    if ( done < blockLength )
+    {
+      fseek( SLI, (long)done, SEEK_SET );
+      fwrite( &block[done], sizeof(u8), blockLength - done, SLI );
+    }
+    else
+    {
+      tally->zeroCopies++;
+    }
+  }
+  else
+#else
+  (void)isPristine;
+#endif
+  {
+    fwrite( block, sizeof(u8), blockLength, SLI );
+  }
+
+  fflush( SLI );
+  fclose( SLI );
+  TRACE_END( TRACE_WRITE, *position, magic );
+  METER_ADD( written, ((coded != (u8 *)0) ? codedLength : blockLength) );
+  tally->hits++;
+  METER_ADD( hits[_getFormatSlot( magic )], 1 );
+
+  if ( depth != 0 )
+  {
+    tally->nested++;
+  }
+
+  if ( dst != (u8 *)0 )
+  {
+    /*----------------------------------------------------------
+    Nested hits are named by the chain of their parents' offsets,
+    e.g. "0x1400_0x40_0x2A0.szs" for a block two levels down.
+    ----------------------------------------------------------*/
+    if ( (toRecurse != 0) && ((lengthName + 24U) < FILENAME_MAX) )
+    {
+      if ( options.verbose != 0 )
+      {
+        u32 code = (sizeDecoded >= 4U) ? _swap32( *(u32 *)dst ) : 0;
+
+        if ( (code == RARC) || (code == U8AR) )
+        {
+          dataEntry[lengthName] = '\0';
+          fprintf( STATUS, "# %s archive: \"%s\"\n",
+                           ((code == RARC) ? "RARC" : "U8"), dataEntry );
+        }
+      }
+
+      dataEntry[lengthName    ] = '_';
+      dataEntry[lengthName + 1] = '\0';
+      scanSLI( dst, sizeDecoded, (u32)0, (u32)0,
+               dataEntry, depth + 1U, tally );
+    }
+  }
+
+#ifdef XSLI_ZEROCOPY
+  if ( mapped != (u8 *)0 )
+  {
+    munmap( mapped, (size_t)sizeDecoded );
+  }
+#endif
+
+  *position += blockLength;
+  return;
+
+err:
+
+#ifdef XSLI_ZEROCOPY
+  if ( mapped != (u8 *)0 )
+  {
+    munmap( mapped, (size_t)sizeDecoded );
+  }
+#endif
+
+  *position = cleanUpOnError( SLI, DECODED, dataEntry, decodedDest );
+  return;
+}
+
+
+
+/*--------------------------------------------------------------------
+"-z" statistics of how each block was encoded, counted by the walks
+of "getBlockLength" and "_decodeChecked" when handed a "shape" to
+fill. Match lengths and distances are counted in buckets of powers of
+2, bucket "i" holding those of 2^i up to 2^(i + 1) - 1. Long matches
+are those of Yay0/Yaz0 taking a length byte of their own [0x12+].
+--------------------------------------------------------------------*/
+#define SHAPE_LENGTHS   9  /* Up to 273, and any longer [LZ11] */
+#define SHAPE_DISTANCES 13 /* Up to 4096 */
+
+struct shape
+{
+  u32 literals;
+  u32 matches;
+  u32 longMatches;
+  u32 lengths[SHAPE_LENGTHS];
+  u32 distances[SHAPE_DISTANCES];
+};
+
+
+
+static int _getBucket( u32 value )
+{
+  int bucket = 0;
+
+  while ( (value >>= 1) != 0 )
+  {
+    ++bucket;
+  }
+
+  return bucket;
+}
+
+static void _countMatch( struct shape *shape, const u32 length,
+                         const u32 distance )
+{
+  int bucket = _getBucket( length );
+
+  shape->matches++;
+  shape->lengths[(bucket < SHAPE_LENGTHS) ? bucket : (SHAPE_LENGTHS - 1)]++;
+  shape->distances[_getBucket( distance )]++;
+  return;
+}
+
+
+
+static u32 _getSizeSLI( const u8 *srcbuf, const u32 position, const u32 xr )
+{
+  return _peek32( srcbuf, position + 0x04U, xr );
+}
+
+static u32 _getSizeSMSR( const u8 *srcbuf, const u32 position, const u32 xr )
+{
+  return _peek32( srcbuf, position + 0x08U, xr );
+}
+
+
+
+/*-------------------------------------------------------------------
+Every read is bounded by "lengthROM", every back-reference must land
+within the data decoded so far, and the last copy must end exactly at
+"sizeDecoded", so that a stream which passes here can be handed to
+"decbuf" without it writing past its buffer. This matters for
+recursive scans, where the data walked is whatever a parent held.
+-------------------------------------------------------------------*/
+static int getBlockLength( const u8 *srcbuf, const u32 position,
+                           const u32 lengthROM, const u32 xr,
+                           const u32 magic, register u32 *blockLength,
+                           struct shape *shape )
+{
+  u32 offset = 0;
+  u32 masks  = 0;
+  u32 flags  = 0;
+  u32 poly   = 0;
+  u32 defs   = 0;
+  u32 displacement;
+  u32 distance;
+  u32 sizeDecoded;
+  i32 operations;
+
+  if ( (lengthROM < 0x10U) || (position > (lengthROM - 0x10U)) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  sizeDecoded = _peek32( srcbuf, position + 0x04U, xr );
+
+  if ( (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  if ( magic != Yaz )
+  {
+    poly = _peek32( srcbuf, position + 0x08U, xr );
+    defs = _peek32( srcbuf, position + 0x0CU, xr );
+
+    if ( (poly == 0) || (defs < poly) || (defs >= (lengthROM - position)) )
+    {
+      return EXIT_FAILURE;
+    }
+
+    poly += position;
+    defs += position;
+    flags = position + 0x10U;
+  }
+  else
+  {
+    if (    (_peek32( srcbuf, position + 0x08U, xr ) != 0)
+         || (_peek32( srcbuf, position + 0x0CU, xr ) != 0) )
+    {
+      return EXIT_FAILURE;
+    }
+
+    defs = position + 0x10U;
+  }
+
+  *blockLength = 16U;
+
+  do
+  {
+    if ( masks == 0 )
+    {
+      if ( magic != Yaz )
+      {
+        if ( (flags + 4U) > lengthROM )
+        {
+          return EXIT_FAILURE;
+        }
+
+        operations = (i32)_peek32( srcbuf, flags, xr );
+        masks  = 32U;
+        flags += 4U;
+        *blockLength += 4U;
+      }
+      else
+      {
+        if ( defs >= lengthROM )
+        {
+          return EXIT_FAILURE;
+        }
+
+        operations = (i32)_peek8( srcbuf, defs++, xr );
+        operations <<= 0x18;
+        masks = 8U;
+        *blockLength += 1U;
+      }
+    }
+    else
+    {
+      if ( operations >= 0 )
+      {
+        if ( (((magic != Yaz) ? poly : defs) + 2U) > lengthROM )
+        {
+          return EXIT_FAILURE;
+        }
+
+        displacement = _peek16( srcbuf, ((magic != Yaz) ? poly : defs), xr );
+
+        if ( (displacement & 0x00000FFFU) >= offset )
+        {
+          return EXIT_FAILURE;
+        }
+
+        distance = (displacement & 0x00000FFFU) + 1U;
+
+        if ( magic != Yaz )
+        {
+          poly += 2U;
+        }
+        else
+        {
+          defs += 2U;
+        }
+
+        if ( ((displacement >> 12) == 0) && (magic != MIO) )
+        {
+          if ( defs >= lengthROM )
+          {
+            return EXIT_FAILURE;
+          }
+
+          displacement  = _peek8( srcbuf, defs++, xr ) + 18U;
+          *blockLength += 3U;
+
+          if ( shape != (struct shape *)0 )
+          {
+            shape->longMatches++;
+          }
+        }
+        else
+        {
+          displacement = (displacement >> 12) + 2U;
+
+          if ( magic == MIO )
+          {
+            ++displacement;
+          }
+
+          *blockLength += 2U;
+          }
+
+        if ( shape != (struct shape *)0 )
+        {
+          _countMatch( shape, displacement, distance );
+        }
+
+        offset += displacement;
+      }
+      else
+      {
+        if ( defs >= lengthROM )
+        {
+          return EXIT_FAILURE;
+        }
+
+        if ( shape != (struct shape *)0 )
+        {
+          shape->literals++;
+        }
+
+        ++defs;
+        ++offset;
+        (*blockLength)++;
+      }
+
+      operations <<= 1;
+      --masks;
+    }
+  }
+  while ( offset < sizeDecoded );
+
+  /*-----------------------------------------------------
+  A last match running past the decoded size would have
+  "decbuf" copy it past the end of its buffer.
+  -----------------------------------------------------*/
+  if ( offset != sizeDecoded )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+/*-------------------------------------------------------------------
+SMSR00 blocks take their length from the CMPR header that wraps them,
+so "getBlockLength" never sees them; they are walked here instead, to
+the same rules, before "decbuf" is trusted with one. Flags and
+back-references share the stream from 0x20 on, literals follow from
+the offset at 0x1C, and "blockLength" bounds them both.
+-------------------------------------------------------------------*/
+static int _walkSMSR( const u8 *srcbuf, const u32 position,
+                      const u32 blockLength, const u32 xr )
+{
+  u32 offset = 0;
+  u32 masks  = 0;
+  u32 end;
+  u32 poly;
+  u32 defs;
+  u32 displacement;
+  u32 sizeDecoded;
+  i32 operations;
+
+  if ( blockLength < 0x20U )
+  {
+    return EXIT_FAILURE;
+  }
+
+  sizeDecoded = _peek32( srcbuf, position + 0x08U, xr );
+  defs        = _peek32( srcbuf, position + 0x1CU, xr );
+
+  if (    (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU)
+       || (defs == 0) || (defs > (blockLength - 0x20U)) )
+  {
+    return EXIT_FAILURE;
+  }
+
+  end   = position + blockLength;
+  poly  = position + 0x20U;
+  defs += poly;
+
+  do
+  {
+    if ( masks == 0 )
+    {
+      if ( (poly + 2U) > end )
+      {
+        return EXIT_FAILURE;
+      }
+
+      operations = (i32)_peek16( srcbuf, poly, xr );
+      operations <<= 0x10;
+      masks = 16U;
+      poly += 2U;
+    }
+    else
+    {
+      if ( operations >= 0 )
+      {
+        if ( (poly + 2U) > end )
+        {
+          return EXIT_FAILURE;
+        }
+
+        displacement = _peek16( srcbuf, poly, xr );
+
+        if ( (displacement & 0x00000FFFU) >= offset )
+        {
+          return EXIT_FAILURE;
+        }
+
+        poly   += 2U;
+        offset += (displacement >> 12) + 3U;
+      }
+      else
+      {
+        if ( defs >= end )
+        {
+          return EXIT_FAILURE;
+        }
+
+        ++defs;
+        ++offset;
+      }
+
+      operations <<= 1;
+      --masks;
+    }
+  }
+  while ( offset < sizeDecoded );
+
+  if ( offset != sizeDecoded )
+  {
+    return EXIT_FAILURE;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+
+/*---------------------------------------------------------------------
+"--verify" decodes every block at the top level of a ROM once more,
+without "decbuf" trusting any of it: every read is bounded by the
+partition it belongs to, every back-reference by the data decoded so
+far, and every copy by "sizeDecoded", which the data must fill. The
+input consumed must then reach the block's length, short of at most
+the 3 bytes that would align it to 32 bits. "-z" also has it walk the
+blocks that "getBlockLength" doesn't.
+---------------------------------------------------------------------*/
+enum
+{
+  VERIFY_OK,
+  VERIFY_HEADER,   /* Sizes or partitions out of bounds */
+  VERIFY_OVERRUN,  /* A read past the end of its partition */
+  VERIFY_BACKREF,  /* A back-reference before the decoded data */
+  VERIFY_OVERFLOW, /* A copy past "sizeDecoded" */
+  VERIFY_LENGTH,   /* Input left over past any alignment */
+  VERIFY_MEMORY,
+  VERIFY_KINDS
+};
+
+static const char *verdicts[VERIFY_KINDS] =
+{
+  "OK",
+  "FAILED: Invalid header",
+  "FAILED: Input overruns its partition",
+  "FAILED: Back-reference before the decoded data",
+  "FAILED: Output overruns the decoded size",
+  "FAILED: Input left over",
+  "FAILED: Out of memory"
+};
+
+
+
+static int _decodeChecked( const u8 *block, const u32 blockLength,
+                           const u32 magic, u8 *dst, const u32 sizeDecoded,
+                           struct shape *shape )
+{
+  u32 written = 0;
+  u32 masks   = 0;
+  u32 flags   = 0;
+  u32 poly    = 0;
+  u32 defs    = 0;
+  u32 flagsEnd = 0;
+  u32 polyEnd  = 0;
+  u32 consumed;
+  u32 displacement;
+  u32 length;
+  i32 operations = 0;
+
+  if (    (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU)
+       || (blockLength < ((magic == SMSR) ? 0x20U : 0x10U)) )
+  {
+    return VERIFY_HEADER;
+  }
+
+  /*-----------------------------------------------------------------
+  MIO0/Yay0 keep flags in [0x10, poly), back-references in
+  [poly, defs) and bytes in [defs, blockLength). SMSR00 interleaves
+  its flags with the back-references from 0x20. Yaz0 is one stream.
+  -----------------------------------------------------------------*/
+  if ( magic == Yaz )
+  {
+    if (    (_peek32( block, 0x08U, 0 ) != 0)
+         || (_peek32( block, 0x0CU, 0 ) != 0) )
+    {
+      return VERIFY_HEADER;
+    }
+
+    defs = 0x10U;
+  }
+  else if ( magic == SMSR )
+  {
+    defs = _peek32( block, 0x1CU, 0 );
+
+    if ( (defs == 0) || (defs > (blockLength - 0x20U)) )
+    {
+      return VERIFY_HEADER;
+    }
+
+    poly    = 0x20U;
+    defs   += 0x20U;
+    polyEnd = defs;
+  }
+  else
+  {
+    poly = _peek32( block, 0x08U, 0 );
+    defs = _peek32( block, 0x0CU, 0 );
+
+    if ( (poly < 0x10U) || (defs < poly) || (defs > blockLength) )
+    {
+      return VERIFY_HEADER;
+    }
+
+    flags    = 0x10U;
+    flagsEnd = poly;
+    polyEnd  = defs;
+  }
+
+  while ( written < sizeDecoded )
+  {
+    if ( masks == 0 )
+    {
+      if ( magic == Yaz )
+      {
+        if ( defs >= blockLength )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        operations = (i32)((u32)block[defs++] << 24);
+        masks = 8U;
+      }
+      else if ( magic == SMSR )
+      {
+        if ( (poly + 2U) > polyEnd )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        operations = (i32)(_peek16( block, poly, 0 ) << 16);
+        masks = 16U;
+        poly += 2U;
+      }
+      else
+      {
+        if ( (flags + 4U) > flagsEnd )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        operations = (i32)_peek32( block, flags, 0 );
+        masks  = 32U;
+        flags += 4U;
+      }
+
+      continue;
+    }
+
+    if ( operations >= 0 )
+    {
+      if ( magic == Yaz )
+      {
+        if ( (defs + 2U) > blockLength )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        displacement = _peek16( block, defs, 0 );
+        defs += 2U;
+      }
+      else
+      {
+        if ( (poly + 2U) > polyEnd )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        displacement = _peek16( block, poly, 0 );
+        poly += 2U;
+      }
+
+      if ( (displacement & 0x0FFFU) >= written )
+      {
+        return VERIFY_BACKREF;
+      }
+
+      if (    ((displacement >> 12) == 0)
+           && (magic != MIO)
+           && (magic != SMSR) )
+      {
+        if ( defs >= blockLength )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        length = (u32)block[defs++] + 18U;
+
+        if ( shape != (struct shape *)0 )
+        {
+          shape->longMatches++;
+        }
+      }
+      else
+      {
+        length = (displacement >> 12) + 2U;
+
+        if ( (magic == MIO) || (magic == SMSR) )
+        {
+          ++length;
+        }
+      }
+
+      if ( length > (sizeDecoded - written) )
+      {
+        return VERIFY_OVERFLOW;
+      }
+
+      displacement = (displacement & 0x0FFFU) + 1U;
+
+      if ( shape != (struct shape *)0 )
+      {
+        _countMatch( shape, length, displacement );
+      }
+
+      while ( length-- != 0 )
+      {
+        dst[written] = dst[written - displacement];
+        ++written;
+      }
+    }
+    else
+    {
+      if ( defs >= blockLength )
+      {
+        return VERIFY_OVERRUN;
+      }
+
+      dst[written++] = block[defs++];
+
+      if ( shape != (struct shape *)0 )
+      {
+        shape->literals++;
+      }
+    }
+
+    operations = (i32)((u32)operations << 1);
+    --masks;
+  }
+
+  /*------------------------------------------------------------
+  Bytes are the last partition of every format, and have always
+  been read from the furthest point of all of them.
+  ------------------------------------------------------------*/
+  consumed = (defs > poly) ? defs : poly;
+
+  return ((blockLength - consumed) > 3U) ? VERIFY_LENGTH : VERIFY_OK;
+}
+
+
+
+/*--------------------------------------------------------------------
+GBA/DS LZ77 ["LZ10", "LZ11"]: a type byte of 0x10 or 0x11, and the
+decoded size in 24 bits, Little-Endian, or 0 then 32 bits [extended].
+Groups of a flag byte and 8 tokens follow, the highest bit first, and
+set for a match. An "LZ10" match is 2 bytes: 4 bits of length - 3 and
+12 of distance - 1. "LZ11" takes its length from the top nibble, or
+for 0 and 1, from 8 or 16 bits after it, taking 3 or 4 bytes:
+  [N D D D]           : N + 1         [3 to 16]
+  [0 N N   D D D]     : NN + 0x11     [17 to 272]
+  [1 N N N N   D D D] : NNNN + 0x111  [273 to 65808]
+"_walkLZ" is the one loop behind the descriptors of both, reading
+"srcbuf" in its byte order up to "limit", and writing to "dst" where
+there is one. Every read and back-reference is bounded regardless.
+--------------------------------------------------------------------*/
+#define LZ_MIN 0x40U
+
+static u32 _getSizeLZ( const u8 *srcbuf, const u32 position, const u32 xr )
+{
+  u32 size =  _peek8( srcbuf, position + 1U, xr )
+           | (_peek8( srcbuf, position + 2U, xr ) << 8)
+           | (_peek8( srcbuf, position + 3U, xr ) << 16);
+
+  if ( size == 0 )
+  {
+    size =  _peek8( srcbuf, position + 4U, xr )
+         | (_peek8( srcbuf, position + 5U, xr ) << 8)
+         | (_peek8( srcbuf, position + 6U, xr ) << 16)
+         | (_peek8( srcbuf, position + 7U, xr ) << 24);
+  }
+
+  return size;
+}
+
+
+
+static int _walkLZ( const u8 *srcbuf, const u32 position, const u32 limit,
+                    const u32 xr, const u32 magic, u8 *dst,
+                    const u32 sizeDecoded, struct shape *shape,
+                    u32 *consumed )
+{
+  u32 at = position +
+           (((_peek32( srcbuf, position, xr ) & 0x00FFFFFFU) != 0) ? 4U : 8U);
+  u32 written = 0;
+  u32 flags   = 0;
+  u32 masks   = 0;
+  u32 code;
+  u32 length;
+  u32 distance;
+
+  while ( written < sizeDecoded )
+  {
+    if ( masks == 0 )
+    {
+      if ( at >= limit )
+      {
+        return VERIFY_OVERRUN;
+      }
+
+      flags = _peek8( srcbuf, at++, xr );
+      masks = 8U;
+    }
+
+    if ( (flags & 0x80U) != 0 )
+    {
+      if ( (at + 2U) > limit )
+      {
+        return VERIFY_OVERRUN;
+      }
+
+      code = _peek8( srcbuf, at, xr );
+
+      if ( magic == LZ10 )
+      {
+        length = (code >> 4) + 3U;
+      }
+      else if ( (code >> 4) > 1U )
+      {
+        length = (code >> 4) + 1U;
+      }
+      else if ( (code >> 4) == 0 )
+      {
+        if ( (at + 3U) > limit )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        length = (((code & 0x0FU) << 4) |
+                  (_peek8( srcbuf, at + 1U, xr ) >> 4)) + 0x11U;
+        code   = _peek8( srcbuf, ++at, xr );
+      }
+      else
+      {
+        if ( (at + 4U) > limit )
+        {
+          return VERIFY_OVERRUN;
+        }
+
+        length = (((code & 0x0FU) << 12) |
+                  (_peek8( srcbuf, at + 1U, xr ) << 4) |
+                  (_peek8( srcbuf, at + 2U, xr ) >> 4)) + 0x111U;
+        at    += 2U;
+        code   = _peek8( srcbuf, at, xr );
+      }
+
+      distance = (((code & 0x0FU) << 8) | _peek8( srcbuf, at + 1U, xr )) + 1U;
+      at += 2U;
+
+      if ( distance > written )
+      {
+        return VERIFY_BACKREF;
+      }
+
+      if ( length > (sizeDecoded - written) )
+      {
+        return VERIFY_OVERFLOW;
+      }
+
+      if ( shape != (struct shape *)0 )
+      {
+        _countMatch( shape, length, distance );
+      }
+
+      if ( dst != (u8 *)0 )
+      {
+        while ( length-- != 0 )
+        {
+          dst[written] = dst[written - distance];
+          ++written;
+        }
+      }
+      else
+      {
+        written += length;
+      }
+    }
+    else
+    {
+      if ( at >= limit )
+      {
+        return VERIFY_OVERRUN;
+      }
+
+      if ( dst != (u8 *)0 )
+      {
+        dst[written] = (u8)_peek8( srcbuf, at, xr );
+      }
+
+      ++at;
+      ++written;
+
+      if ( shape != (struct shape *)0 )
+      {
+        shape->literals++;
+      }
+    }
+
+    flags <<= 1;
+    --masks;
+  }
+
+  *consumed = at - position;
+  return VERIFY_OK;
+}
+
+
+
+/*-------------------------------------------------------------------
+With no FourCC to go by, a candidate must be 32-bit aligned, as the
+BIOS requires, decode to "LZ_MIN" bytes or more, open with a literal
+and walk cleanly to fewer bytes than it decodes to; anything else is
+taken for other data, not an oddity.
+-------------------------------------------------------------------*/
+static int _getLZLength( const u8 *srcbuf, const u32 position,
+                         const u32 lengthROM, const u32 xr,
+                         const u32 magic, register u32 *blockLength,
+                         struct shape *shape )
+{
+  u32 sizeDecoded = _getSizeLZ( srcbuf, position, xr );
+  u32 header = ((_peek32( srcbuf, position, xr ) & 0x00FFFFFFU) != 0) ?
+               4U : 8U;
+  u32 consumed = 0;
+
+  if (    ((position & 3U) != 0)
+       || (sizeDecoded < LZ_MIN) || (sizeDecoded >= 0x3FFFFFFFU)
+       || ((_peek8( srcbuf, position + header, xr ) & 0x80U) != 0) )
+  {
+    return MEASURE_NONE;
+  }
+
+  if (    (_walkLZ( srcbuf, position, lengthROM, xr, magic, (u8 *)0,
+                    sizeDecoded, shape, &consumed ) != VERIFY_OK)
+       || (consumed >= sizeDecoded) )
+  {
+    return MEASURE_NONE;
+  }
+
+  *blockLength = consumed;
+  return EXIT_SUCCESS;
+}
+
+
+
+static int _checkLZ( const u8 *block, const u32 blockLength,
+                     const u32 magic, u8 *dst, const u32 sizeDecoded,
+                     struct shape *shape )
+{
+  u32 consumed = 0;
+  int verdict;
+
+  if (    (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU)
+       || (blockLength < 8U)
+       || (block[0] != ((magic == LZ10) ? 0x10U : 0x11U)) )
+  {
+    return VERIFY_HEADER;
+  }
+
+  verdict = _walkLZ( block, 0, blockLength, 0, magic, dst,
+                     sizeDecoded, shape, &consumed );
+
+  if ( verdict != VERIFY_OK )
+  {
+    return verdict;
+  }
+
+  return ((blockLength - consumed) > 3U) ? VERIFY_LENGTH : VERIFY_OK;
+}
+
+
+
+/*-----------------------------------------------------------
+As "decbuf", for a block already measured by "_getLZLength".
+-----------------------------------------------------------*/
+static void _decodeLZ( const u8 *srcbuf, u8 **dst, const u32 position,
+                       const u32 magic, const u32 sizeDecoded )
+{
+  u32 consumed;
+
+  if ( (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU) )
+  {
+    *dst = (u8 *)0;
+    return;
+  }
+
+  if ( *dst == (u8 *)0 )
+  {
+    return;
+  }
+
+  if ( _walkLZ( srcbuf, position, 0xFFFFFFFFU, 0, magic, *dst,
+                sizeDecoded, (struct shape *)0, &consumed ) != VERIFY_OK )
+  {
+    *dst = (u8 *)0;
+    return;
+  }
+
+  METER_ADD( decoded, sizeDecoded );
+  return;
+}
+
+
+
+static void postDiscrepancy( const u8 *srcbuf, const u32 xr,
+                             const u32 position, const u32 oddities )
+{
+  fprintf( STATUS,
+           "___[#%u]___QUESTIONABLE_DATA_SEQUENCE___\n"
+           "0x%X -> [0x%X]\n0x%X -> [0x%X]\n0x%X -> [0x%X]\n0x%X -> [0x%X]\n",
+           oddities,
+           position, _peek32( srcbuf, position, xr ),
+           (u32)(position + 0x4U), _peek32( srcbuf, position + 0x04U, xr ),
+           (u32)(position + 0x8U), _peek32( srcbuf, position + 0x08U, xr ),
+           (u32)(position + 0xCU), _peek32( srcbuf, position + 0x0CU, xr ) );
+  return;
+}
+
+
+
+/*-------------------------------------------------------------------
+Returns the Big-Endian bytes of a block; in place when "xr" is zero,
+otherwise in the pool's block buffer for "depth".
+-------------------------------------------------------------------*/
+static u8 *_getBlock( u8 *srcbuf, const u32 position, const u32 length,
+                      const u32 xr, struct pool *pool, const u32 depth )
+{
+  u8 *scratch;
+
+  if ( xr == 0 )
+  {
+    return &srcbuf[position];
+  }
+
+  if ( (scratch = (u8 *)_poolGet( pool, POOL_BLOCK, depth, length )) == 0 )
+  {
+    if ( options.verbose != 0 )
+    {
+      fprintf( STATUS,
+               "\n>>> Unable to allocate for byte ordering a block!\n\n" );
+    }
+
+    return (u8 *)0;
+  }
+
+  _unswizzle( scratch, srcbuf, position, length, xr );
+  return scratch;
+}
+
+
+
+/*-------------------------------------------------------------------
+Rebases the 20-byte "MIO0" header of "Body Harvest", from a copy of
+the block taken 4 bytes into it, onto the standard 16-byte header.
+See the "Body Harvest" case of "scanSLI".
+-------------------------------------------------------------------*/
+static void _patchHeader( u8 *block, const u32 magic )
+{
+  *(u32 *)&block[0x00U] = _swap32( magic );
+  *(u32 *)&block[0x08U] = _swap32( _swap32( *(u32 *)&block[0x08U] ) - 4U );
+  *(u32 *)&block[0x0CU] = _swap32( _swap32( *(u32 *)&block[0x0CU] ) - 4U );
+  return;
+}
+
+
+
+/*--------------------------------------------------------------------
+Per-title quirk profiles, for titles that deviate from the standard
+SLI layout or are problematic from unresolved discrepancies.
+A new problem title is handled by adding an entry here.
+
+  id        : Game IDs [NTSC, PAL] read from 0x3B of the ROM header.
+  formats   : Formats scanned for, as a mask of "FMT_*" bits.
+  header    : Length of the "MIO0" header; 0x10 is standard.
+  alignment : Bits of a candidate's offset that must be clear.
+  prefix    : FourCC expected 16 bytes before each "MIO0" header,
+              once any "MIO0" has been seen preceded by it.
+
+The last entry is the profile for every other title, and nested data.
+--------------------------------------------------------------------*/
+struct quirk
+{
+  u32 id[2];
+  u32 formats;
+  u32 header;
+  u32 alignment;
+  u32 prefix;
+  const char *title;
+};
+
+
+
+static const struct quirk quirks[] =
+{
+  /*----------------------------------------------------
+  DMA Design Limited [a.k.a. Rockstar North] used a
+  non-standard SLI header in their title "Body Harvest".
+  ----------------------------------------------------*/
+  { { 0x4E424845U, 0x4E424850U }, FMT_ALL, 0x14U, 0, 0,
+    "Body Harvest" },
+  /*---------------------------------------------------------------
+  If the FourCC "MIO0" isn't preceded by "GZIP" 16 bytes prior, the
+  "MIO0" header contains unusual information at 0x8 and 0xC.
+  ---------------------------------------------------------------*/
+  { { 0x4E445545U, 0x4E445550U }, FMT_ALL, 0x10U, 0, GZIP,
+    "Looney Tunes: Duck Dodgers Starring Daffy Duck" },
+  /*-----------------------------------------------------------
+  Hack to keep from crashing when dumping from Scooby-Doo! CCC.
+  This hasn't been tested for accuracy or inadvertent deficits.
+  -----------------------------------------------------------*/
+  { { 0x4E535945U, 0x4E535950U }, FMT_ALL, 0x10U, 1, GZIP,
+    "Scooby-Doo! Classic Creep Capers" },
+  { { 0, 0 }, FMT_ALL, 0x10U, 0, GZIP, "None" }
+};
+
+
+
+static const struct quirk *_getQuirk( const u32 id32 )
+{
+  register const struct quirk *quirk = quirks;
+
+  while ( (quirk->id[0] != 0) && (quirk->id[0] != id32)
+                              && (quirk->id[1] != id32) )
+  {
+    ++quirk;
+  }
+
+  return quirk;
+}
+
+
+
+/*-------------------------------------------------------------------
+The Big-Endian bytes of a block indexed at the top level of a ROM,
+as "scanSLI" would hand them on; in place where they can be.
+-------------------------------------------------------------------*/
+static u8 *_getHitBlock( u8 *srcbuf, const u32 xr, const struct quirk *quirk,
+                         const struct hit *hit, struct pool *pool )
+{
+  unsigned isPatched = (quirk->header == 0x14U) && (hit->magic == MIO);
+  u8 *block;
+
+  if ( (xr == 0) && (isPatched == 0) )
+  {
+    return &srcbuf[hit->offset];
+  }
+
+  if ( (block = (u8 *)_poolGet( pool, POOL_BLOCK, 0, hit->raw )) == (u8 *)0 )
+  {
+    return (u8 *)0;
+  }
+
+  _unswizzle( block, srcbuf, hit->offset, hit->raw, xr );
+
+  if ( isPatched != 0 )
+  {
+    _patchHeader( block, hit->magic );
+  }
+
+  return block;
+}
+
+
+
+/*--------------------------------------------------------------------
+Selective extraction filters, applied as early in the scan as each
+allows; excluded blocks are never walked, decoded, listed or written.
+
+  formats   : Formats extracted, as a mask of "FMT_*" bits.
+  ranges    : Offset ranges [start, end) that a ROM is scanned within.
+  offsets   : Sorted list of the only offsets that a ROM is checked at.
+  raw       : Inclusive bounds on the length of a block.
+  decoded   : Inclusive bounds on the decoded size, from the header.
+
+Ranges and offsets select from a ROM together, and are not applied to
+nested data; "isWindowed" is set when either has been given.
+--------------------------------------------------------------------*/
+#define RANGES_MAX 64
+
+
+
+static struct
+{
+  u32  formats;
+  u32  countRanges;
+  u32  ranges[RANGES_MAX][2];
+  u32  countOffsets;
+  u32 *offsets;
+  u32  raw[2];
+  u32  decoded[2];
+  unsigned isWindowed;
+  unsigned isActive;
+}
+filter;
+
+
+
+/*------------------------------------------------------------------
+Moves "*position" to the next offset that the filters allow, and
+sets "*window" to where that allowance ends. Returns zero once no
+allowed offsets remain.
+------------------------------------------------------------------*/
+static int _nextWindow( u32 *position, u32 *window )
+{
+  u32 start = 0xFFFFFFFFU;
+  u32 end   = 0;
+  u32 i     = 0;
+
+  while ( i < filter.countRanges )
+  {
+    if ( filter.ranges[i][1] > *position )
+    {
+      u32 low = (filter.ranges[i][0] > *position) ?
+                filter.ranges[i][0] : *position;
+
+      if ( (low < start) || ((low == start) && (filter.ranges[i][1] > end)) )
+      {
+        start = low;
+        end   = filter.ranges[i][1];
+      }
+    }
+
+    ++i;
+  }
+
+  if ( filter.countOffsets != 0 )
+  {
+    u32 low  = 0;
+    u32 high = filter.countOffsets;
+
+    while ( low < high )
+    {
+      u32 middle = low + ((high - low) >> 1);
+
+      if ( filter.offsets[middle] < *position )
+      {
+        low = middle + 1U;
+      }
+      else
+      {
+        high = middle;
+      }
+    }
+
+    if ( (low < filter.countOffsets) && (filter.offsets[low] < start) )
+    {
+      start = filter.offsets[low];
+      end   = start + 1U;
+    }
+  }
+
+  if ( start == 0xFFFFFFFFU )
+  {
+    return 0;
+  }
+
+  *position = start;
+  *window   = end;
+  return 1;
+}
+
+
+
+static int _isBounded( const u32 size, const u32 bounds[2] )
+{
+  return (size >= bounds[0]) && (size <= bounds[1]);
+}
+
+
+
+/*---------------------------------------------------------------------
+A coarse map of a ROM in chunks of "REGION_SIZE" bytes, taken before
+it's scanned. As no FourCC scanned for is one byte repeated, no header
+can start where its first 4 bytes are all within a chunk of a single
+repeated byte [padding], and the scan steps over all such offsets at
+once. "-i" grades the remaining chunks by their entropy as well, which
+costs a second pass, and prints the map.
+---------------------------------------------------------------------*/
+#define REGION_SIZE  0x1000U
+#define REGION_SHIFT 12
+#define REGION_DENSE 7.0 /* Bits per byte from which data is "HIGH" */
+
+enum
+{
+  REGION_MIXED,   /* Not graded */
+  REGION_UNIFORM, /* One byte repeated */
+  REGION_LOW,     /* Code, tables, uncompressed audio/graphics */
+  REGION_HIGH     /* Compressed, or otherwise dense data */
+};
+
+
+
+/*-----------------------------------------------------------------
+Differences are gathered 64 bytes at a time before being tested,
+which leaves the loop without a branch for compilers to vectorize.
+-----------------------------------------------------------------*/
+static int _isUniform( const u8 *chunk, const u32 length )
+{
+  u32 fill = (u32)chunk[0] * 0x01010101U;
+  u32 i    = 0;
+
+  if ( (length & 0x3FU) != 0 )
+  {
+    while ( (i < length) && (chunk[i] == chunk[0]) )
+    {
+      ++i;
+    }
+
+    return i == length;
+  }
+
+  while ( i < length )
+  {
+    const u32 *words = (const u32 *)&chunk[i];
+    u32 differs = 0;
+    int j;
+
+    for ( j = 0; j < 16; ++j )
+    {
+      differs |= words[j] ^ fill;
+    }
+
+    if ( differs != 0 )
+    {
+      return 0;
+    }
+
+    i += 0x40U;
+  }
+
+  return 1;
+}
+
+
+
+static double _getEntropy( const u8 *chunk, const u32 length )
+{
+  u32 counts[256];
+  double entropy = 0.0;
+  u32 i = 0;
+
+  memset( counts, 0, sizeof(counts) );
+
+  while ( i < length )
+  {
+    counts[chunk[i++]]++;
+  }
+
+  for ( i = 0; i < 256U; ++i )
+  {
+    if ( counts[i] != 0 )
+    {
+      double p = (double)counts[i] / length;
+
+      entropy -= p * log( p );
+    }
+  }
+
+  return entropy / log( 2.0 );
+}
+
+
+
+/*-----------------------------------------------------------------
+"regions" has a byte for each chunk, the last of which may be short.
+-----------------------------------------------------------------*/
+static void _mapRegions( const u8 *srcbuf, const u32 lengthROM,
+                         u8 *regions, const unsigned isGraded )
+{
+  u32 chunk = 0;
+
+  while ( chunk < lengthROM )
+  {
+    u32 length = ((lengthROM - chunk) < REGION_SIZE) ?
+                 (lengthROM - chunk) : REGION_SIZE;
+    u8 *region = &regions[chunk >> REGION_SHIFT];
+
+    if ( _isUniform( &srcbuf[chunk], length ) )
+    {
+      *region = REGION_UNIFORM;
+    }
+    else if ( isGraded != 0 )
+    {
+      *region = (_getEntropy( &srcbuf[chunk], length ) >= REGION_DENSE) ?
+                REGION_HIGH : REGION_LOW;
+    }
+    else
+    {
+      *region = REGION_MIXED;
+    }
+
+    chunk += length;
+  }
+
+  return;
+}
+
+
+
+/*------------------------------------------------------------------
+Prints the map as runs of chunks of the same grade, and fill byte for
+padding, with the share of the ROM taken by each grade. Offsets are
+those of the file, in its own byte order.
+------------------------------------------------------------------*/
+static void _putRegions( const u8 *srcbuf, const u32 lengthROM,
+                         const u8 *regions )
+{
+  static const char *grades[] = { "MIXED", "UNIFORM", "LOW", "HIGH" };
+  u32 totals[4];
+  u32 start = 0;
+
+  memset( totals, 0, sizeof(totals) );
+  fprintf( STATUS, "# Regions [%u KiB chunks]:\n", REGION_SIZE >> 10 );
+
+  while ( start < lengthROM )
+  {
+    u8  grade = regions[start >> REGION_SHIFT];
+    u32 end   = start;
+
+    do
+    {
+      end = ((lengthROM - end) < REGION_SIZE) ? lengthROM : end + REGION_SIZE;
+    }
+    while (    (end < lengthROM)
+            && (regions[end >> REGION_SHIFT] == grade)
+            && (    (grade != REGION_UNIFORM)
+                 || (srcbuf[end] == srcbuf[start]) ) );
+
+    if ( grade == REGION_UNIFORM )
+    {
+      fprintf( STATUS, "#   0x%08X-0x%08X  %-7s 0x%02X  %8u KiB\n",
+                       start, end, grades[grade], (u32)srcbuf[start],
+                       (end - start + 0x3FFU) >> 10 );
+    }
+    else
+    {
+      fprintf( STATUS, "#   0x%08X-0x%08X  %-7s       %8u KiB\n",
+                       start, end, grades[grade],
+                       (end - start + 0x3FFU) >> 10 );
+    }
+
+    totals[grade] += end - start;
+    start = end;
+  }
+
+  fprintf( STATUS, "# Uniform: %5.1f%%\n# Low:     %5.1f%%\n"
+                   "# High:    %5.1f%%\n",
+                   totals[REGION_UNIFORM] * 100.0 / lengthROM,
+                   totals[REGION_LOW]     * 100.0 / lengthROM,
+                   totals[REGION_HIGH]    * 100.0 / lengthROM );
+  return;
+}
+
+
+
+static const char *_getFormatName( const u32 magic )
+{
+  return _getFormatInfo( magic )->name;
+}
+
+
+
+/*--------------------------------------------------------------
+Writes a string to "OUT", quoted for a CSV field or JSON string.
+--------------------------------------------------------------*/
+static void _putQuoted( FILE *OUT, const char *text, const int json )
+{
+  fputc( '"', OUT );
+
+  while ( *text != '\0' )
+  {
+    if ( json != 0 )
+    {
+      if ( (*text == '"') || (*text == '\\') )
+      {
+        fputc( '\\', OUT );
+      }
+      else
+      {
+        if ( (unsigned char)*text < 0x20U )
+        {
+          fprintf( OUT, "\\u%04X", (unsigned)(unsigned char)*text++ );
+          continue;
+        }
+      }
+    }
+    else
+    {
+      if ( *text == '"' )
+      {
+        fputc( '"', OUT );
+      }
+    }
+
+    fputc( *text++, OUT );
+  }
+
+  fputc( '"', OUT );
+  return;
+}
+
+
+
+static void _addHit( struct index *index, const u32 offset,
+                     const u32 magic, const u32 raw, const u32 decoded )
+{
+  struct hit *hit;
+
+  if ( index->count == index->capacity )
+  {
+    u32 capacity = (index->capacity != 0) ? (index->capacity << 1) : 64U;
+
+    if ( (hit = (struct hit *)realloc( index->hits,
+                                       sizeof(struct hit) * capacity ))
+         == (struct hit *)0 )
+    {
+      index->isTruncated = 1;
+      return;
+    }
+
+    index->hits     = hit;
+    index->capacity = capacity;
+  }
+
+  hit = &index->hits[index->count++];
+  hit->offset  = offset;
+  hit->magic   = magic;
+  hit->raw     = raw;
+  hit->decoded = decoded;
+  return;
+}
+
+
+
+/*---------------------------------------------------------------------
+The "-l" counterpart to "writeSLI", printing one record for the block
+at "base" of "srcbuf" rather than creating any files. Nothing is
+allocated unless the block must be decoded for a recursive scan.
+Nested records are named by their parent chain, as with "writeSLI".
+With an index in "tally", the block is only added to it instead.
+---------------------------------------------------------------------*/
+static void listSLI( u8 *srcbuf, const u32 base, const u32 xr,
+                     const u32 position, const u32 blockLength,
+                     const u32 magic, const char *path, const u32 depth,
+                     struct tally *tally )
+{
+  char name[FILENAME_MAX];
+  u32  sizeDecoded;
+  u32  crc = 0;
+  double ratio;
+
+  sizeDecoded = _getFormatInfo( magic )->getSize( srcbuf, base, xr );
+
+  if ( tally->index != (struct index *)0 )
+  {
+    _addHit( tally->index, position, magic, blockLength, sizeDecoded );
+    tally->hits++;
+    METER_ADD( hits[_getFormatSlot( magic )], 1 );
+    return;
+  }
+
+  ratio = (sizeDecoded != 0) ? ((double)blockLength / sizeDecoded) : 0.0;
+  sprintf( name, "%s0x%X", path, position );
+
+  if ( options.checksum != 0 )
+  {
+    crc = _crc32( srcbuf, base, blockLength, xr );
+  }
+
+  switch ( options.listMode )
+  {
+    case LIST_CSV:
+      _putQuoted( stdout, tally->pathROM, 0 );
+      printf( ",%s,%u,%s,%u,%u,%.4f",
+              name, position, _getFormatName( magic ),
+              blockLength, sizeDecoded, ratio );
+
+      if ( options.checksum != 0 )
+      {
+        printf( ",%08X", crc );
+      }
+
+      putchar( '\n' );
+      break;
+    case LIST_JSON:
+      printf( "{\"rom\":" );
+      _putQuoted( stdout, tally->pathROM, 1 );
+      printf( ",\"name\":\"%s\",\"offset\":%u,\"format\":\"%s\","
+              "\"raw\":%u,\"decoded\":%u,\"ratio\":%.4f",
+              name, position, _getFormatName( magic ),
+              blockLength, sizeDecoded, ratio );
+
+      if ( options.checksum != 0 )
+      {
+        printf( ",\"crc32\":\"%08X\"", crc );
+      }
+
+      printf( "}\n" );
+      break;
+    default:
+      printf( "%-24s %s %10u %10u %7.2f%%",
+              name, _getFormatName( magic ),
+              blockLength, sizeDecoded, ratio * 100.0 );
+
+      if ( options.checksum != 0 )
+      {
+        printf( "  %08X", crc );
+      }
+
+      putchar( '\n' );
+      break;
+  }
+
+  tally->hits++;
+  METER_ADD( hits[_getFormatSlot( magic )], 1 );
+
+  if ( depth != 0 )
+  {
+    tally->nested++;
+  }
+
+  if (    (    (depth < options.maxDepth)
+            && ((strlen( name ) + 24U) < FILENAME_MAX) )
+       || (similarity.isAdding != 0) )
+  {
+    u8 *block = (u8 *)0;
+    u8 *dst   = (u8 *)0;
+
+    if ( (block = _getBlock( srcbuf, base, blockLength,
+                             xr, tally->pool, depth )) != (u8 *)0 )
+    {
+      dst = (u8 *)_poolGet( tally->pool, POOL_DECODED, depth, sizeDecoded );
+      TRACE_BEGIN( TRACE_DECODE, position, magic );
+      _decodeBlock( block, &dst, magic, sizeDecoded );
+      TRACE_END( TRACE_DECODE, position, magic );
+    }
+
+    if ( dst != (u8 *)0 )
+    {
+      _indexBlock( name, strlen( name ), position, depth, magic,
+                   blockLength, dst, sizeDecoded );
+
+      if (    (depth < options.maxDepth)
+           && ((strlen( name ) + 24U) < FILENAME_MAX) )
+      {
+        strcat( name, "_" );
+        scanSLI( dst, sizeDecoded, (u32)0, (u32)0, name, depth + 1U,
+                 tally );
+      }
+    }
+  }
+
+  return;
+}
+
+
+
+/*---------------------------------------------------------------------
+"-z" writes a line of JSON to its file for each ROM: a record for each
+block found, in the order they were found, and the same figures again
+for each format, with histograms of match lengths and distances. See
+"struct shape" for the buckets. "ratio" is raw over decoded bytes, as
+with "-l", and "bitsPerByte" is the raw bits spent per decoded byte.
+---------------------------------------------------------------------*/
+static struct
+{
+  const char *path;
+  FILE *JSON;
+  /*---------------------------------------------------------------
+  "block" is what each walk fills, and "formats" the sums for the
+  ROM so far, of "blocks" blocks of "raw" bytes that decode to
+  "decoded"; "count" is of the block records written for it.
+  ---------------------------------------------------------------*/
+  struct shape block;
+  struct shape formats[FORMAT_SLOTS];
+  u32 blocks[FORMAT_SLOTS];
+  u32 raw[FORMAT_SLOTS];
+  u32 decoded[FORMAT_SLOTS];
+  u32 count;
+}
+analytics;
+
+
+
+static void _putShape( const u32 position, const u32 depth, const u32 magic,
+                       const u32 blockLength, const u32 sizeDecoded )
+{
+  const struct shape *block = &analytics.block;
+  struct shape *format;
+  int slot = _getFormatSlot( magic );
+  int i;
+
+  fprintf( analytics.JSON,
+           "%s{\"offset\":%u,\"depth\":%u,\"format\":\"%s\",\"raw\":%u,"
+           "\"decoded\":%u,\"literals\":%u,\"matches\":%u,"
+           "\"longMatches\":%u,\"ratio\":%.4f,\"bitsPerByte\":%.4f}",
+           (analytics.count++ != 0) ? "," : "",
+           position, depth, _getFormatName( magic ), blockLength,
+           sizeDecoded, block->literals, block->matches, block->longMatches,
+           (double)blockLength / sizeDecoded,
+           (double)blockLength * 8.0 / sizeDecoded );
+
+  format = &analytics.formats[slot];
+  format->literals    += block->literals;
+  format->matches     += block->matches;
+  format->longMatches += block->longMatches;
+
+  for ( i = 0; i < SHAPE_LENGTHS; ++i )
+  {
+    format->lengths[i] += block->lengths[i];
+  }
+
+  for ( i = 0; i < SHAPE_DISTANCES; ++i )
+  {
+    format->distances[i] += block->distances[i];
+  }
+
+  analytics.blocks[slot]++;
+  analytics.raw[slot]     += blockLength;
+  analytics.decoded[slot] += sizeDecoded;
+  return;
+}
+
+
+
+/*---------------------------------------------------------------
+For CMPR blocks, and the "MIO0" blocks of "Body Harvest", whose
+lengths come from their headers rather than "getBlockLength".
+---------------------------------------------------------------*/
+static void _takeShape( const u8 *block, const u32 position,
+                        const u32 depth, const u32 magic,
+                        const u32 blockLength, const u32 sizeDecoded,
+                        struct pool *pool )
+{
+  u8 *dst;
+
+  memset( &analytics.block, 0, sizeof(analytics.block) );
+
+  if (    (sizeDecoded == 0) || (sizeDecoded >= 0x3FFFFFFFU)
+       || ((dst = (u8 *)_poolGet( pool, POOL_DECODED, depth, sizeDecoded ))
+           == (u8 *)0) )
+  {
+    return;
+  }
+
+  if ( _decodeChecked( block, blockLength, magic, dst, sizeDecoded,
+                       &analytics.block ) == VERIFY_OK )
+  {
+    _putShape( position, depth, magic, blockLength, sizeDecoded );
+  }
+
+  return;
+}
+
+
+
+static void _beginShapes( const char *path )
+{
+  memset( analytics.formats, 0, sizeof(analytics.formats) );
+  memset( analytics.blocks,  0, sizeof(analytics.blocks) );
+  memset( analytics.raw,     0, sizeof(analytics.raw) );
+  memset( analytics.decoded, 0, sizeof(analytics.decoded) );
+  analytics.count = 0;
+  fprintf( analytics.JSON, "{\"rom\":" );
+  _putQuoted( analytics.JSON, path, 1 );
+  fprintf( analytics.JSON, ",\"blocks\":[" );
+  return;
+}
+
+
+
+static void _endShapes( void )
+{
+  int slot;
+  int i;
+  int isFirst = 1;
+
+  fprintf( analytics.JSON, "],\"formats\":{" );
+
+  for ( slot = 0; slot < FORMAT_SLOTS; ++slot )
+  {
+    const struct shape *format = &analytics.formats[slot];
+    double decoded = (analytics.decoded[slot] != 0) ?
+                     (double)analytics.decoded[slot] : 1.0;
+
+    if ( analytics.blocks[slot] == 0 )
+    {
+      continue;
+    }
+
+    fprintf( analytics.JSON,
+             "%s\"%s\":{\"blocks\":%u,\"raw\":%u,\"decoded\":%u,"
+             "\"literals\":%u,\"matches\":%u,\"longMatches\":%u,"
+             "\"ratio\":%.4f,\"bitsPerByte\":%.4f,\"lengths\":[",
+             (isFirst != 0) ? "" : ",", formats[slot].name,
+             analytics.blocks[slot], analytics.raw[slot],
+             analytics.decoded[slot], format->literals, format->matches,
+             format->longMatches, analytics.raw[slot] / decoded,
+             analytics.raw[slot] * 8.0 / decoded );
+
+    for ( i = 0; i < SHAPE_LENGTHS; ++i )
+    {
+      fprintf( analytics.JSON, "%s%u", (i != 0) ? "," : "",
+                               format->lengths[i] );
+    }
+
+    fprintf( analytics.JSON, "],\"distances\":[" );
+
+    for ( i = 0; i < SHAPE_DISTANCES; ++i )
+    {
+      fprintf( analytics.JSON, "%s%u", (i != 0) ? "," : "",
+                               format->distances[i] );
+    }
+
+    fprintf( analytics.JSON, "]}" );
+    isFirst = 0;
+  }
+
+  fprintf( analytics.JSON, "}}\n" );
+  fflush( analytics.JSON );
+  return;
+}
+
+
+
+/*--------------------------------------------------------------------
+"-e" writes a stream of frames to the standard output instead of any
+files, for "xsli" to sit in a pipeline. Each frame is a header of six
+Big-Endian u32s followed by its payload:
+
+  FORMAT, OFFSET, DEPTH, FLAGS, RAW LENGTH, DECODED LENGTH
+
+FORMAT is a block's FourCC ["CMPR" for CMPR/SMSR00], and the payload
+is the raw block when FLAGS has bit 0 set, followed by the decoded
+data when bit 1 is set; bit 1 is clear for data that didn't decode.
+Each ROM starts with a frame of FORMAT "ROM ", DECODED LENGTH being
+the ROM's and the payload its path, of RAW LENGTH bytes. Frames of
+nested blocks [-r] follow the frame of the block they were found in,
+at one more DEPTH, with OFFSET into its decoded data.
+--------------------------------------------------------------------*/
+#define FRAME_ROM 0x524F4D20
+
+static int _putFrame( const u32 header[6],
+                      const u8 *raw, const u32 rawLength,
+                      const u8 *decoded, const u32 decodedLength )
+{
+  u32 frame[6];
+  u32 i = 0;
+
+  while ( i < 6 )
+  {
+    frame[i] = _swap32( header[i] );
+    ++i;
+  }
+
+#ifdef XSLI_GATHER
+  {
+    struct iovec parts[3];
+    struct iovec *part = parts;
+    int count = 3;
+
+    parts[0].iov_base = (void *)frame;
+    parts[0].iov_len  = sizeof(frame);
+    parts[1].iov_base = (void *)raw;
+    parts[1].iov_len  = rawLength;
+    parts[2].iov_base = (void *)decoded;
+    parts[2].iov_len  = decodedLength;
+
+    /*-----------------------------------------------------------
+    A pipe may take less than a whole frame, so "writev" picks up
+    wherever the last call left off.
+    -----------------------------------------------------------*/
+    while ( count != 0 )
+    {
+      ssize_t size = writev( STDOUT_FILENO, part, count );
+
+      if ( size < 0 )
+      {
+        if ( errno == EINTR )
+        {
+          continue;
+        }
+
+        return 1;
+      }
+
+      while ( (count != 0) && ((size_t)size >= part->iov_len) )
+      {
+        size -= (ssize_t)part->iov_len;
+        ++part;
+        --count;
+      }
+
+      if ( count != 0 )
+      {
+        part->iov_base = (void *)((u8 *)part->iov_base + size);
+        part->iov_len -= (size_t)size;
+      }
+    }
+  }
+
+  return 0;
+#else
+  return    (fwrite( frame, sizeof(frame), 1, stdout ) != 1)
+         || (fwrite( raw, sizeof(u8), rawLength, stdout ) != rawLength)
+         || (fwrite( decoded, sizeof(u8), decodedLength, stdout )
+             != decodedLength);
+#endif
+}
+
+
+
+/*------------------------------------------------------------------
+The "-e" counterpart to "writeSLI", with the same arguments as far
+as they go; "*position" is likewise zero after a failed write.
+------------------------------------------------------------------*/
+static void emitSLI( const u8 *block, register u32 *position,
+                     const u32 blockLength, struct tally *tally,
+                     const u32 magic, const u32 depth )
+{
+  u32 header[6];
+  u32 sizeDecoded = _getDecodedSize( block, magic );
+  u8 *dst = (u8 *)0;
+  int isWritten;
+
+  header[0] = _getFormatInfo( magic )->tag;
+  header[1] = *position;
+  header[2] = depth;
+  header[3] = options.emitMode & EMIT_RAW;
+  header[4] = blockLength;
+  header[5] = sizeDecoded;
+
+  if (    ((options.emitMode & EMIT_DECODED) != 0)
+       || (depth < options.maxDepth) || (similarity.isAdding != 0) )
+  {
+    dst = (u8 *)_poolGet( tally->pool, POOL_DECODED, depth, sizeDecoded );
+
+    if ( dst != (u8 *)0 )
+    {
+      TRACE_BEGIN( TRACE_DECODE, *position, magic );
+      _decodeBlock( block, &dst, magic, sizeDecoded );
+      TRACE_END( TRACE_DECODE, *position, magic );
+    }
+
+    if ( dst != (u8 *)0 )
+    {
+      char name[16];
+
+      sprintf( name, "0x%X", *position );
+      _indexBlock( name, strlen( name ), *position, depth, magic,
+                   blockLength, dst, sizeDecoded );
+    }
+
+    if ( (dst != (u8 *)0) && ((options.emitMode & EMIT_DECODED) != 0) )
+    {
+      header[3] |= EMIT_DECODED;
+    }
+  }
+
+  TRACE_BEGIN( TRACE_WRITE, *position, magic );
+  isWritten = _putFrame( header,
+                         block, ((header[3] & EMIT_RAW) != 0) ?
+                                blockLength : 0,
+                         dst, ((header[3] & EMIT_DECODED) != 0) ?
+                              sizeDecoded : 0 ) == 0;
+  TRACE_END( TRACE_WRITE, *position, magic );
+  METER_ADD( written, (((header[3] & EMIT_RAW) != 0) ? blockLength : 0) +
+                      (((header[3] & EMIT_DECODED) != 0) ? sizeDecoded : 0) );
+
+  if ( !isWritten )
+  {
+    fprintf( STATUS, "\n>>> Unable to write to the standard output!\n\n" );
+    *position = 0;
+    return;
+  }
+
+  tally->hits++;
+  METER_ADD( hits[_getFormatSlot( magic )], 1 );
+
+  if ( depth != 0 )
+  {
+    tally->nested++;
+  }
+
+  if ( (dst != (u8 *)0) && (depth < options.maxDepth) )
+  {
+    scanSLI( dst, sizeDecoded, (u32)0, (u32)0, "", depth + 1U, tally );
+  }
+
+  *position += blockLength;
+  return;
+}
+
+
+
+/*---------------------------------------------------------------------
+"--carve" looks, after the scan of a ROM, for Yaz0 streams whose header
+was stripped, or made over into a table of the title's own. MIO0 and
+Yay0 split their data into partitions only their headers point to, so
+Yaz0's is the one coding that can be found without one.
+
+Chunks of the region map are probed first, by their entropy: only the
+32-bit aligned offsets of one at least "density" bits per byte, or of
+one just before it, are tried. A trial walks the tokens at an offset
+with every read bounded, and writes nothing. Until a window of 4 KiB
+has been decoded, a random distance only fits in the data decoded so
+far by chance, so each match that fits is 12 - log2 [decoded] "bits"
+of evidence of a stream. Whatever hasn't enough once the window is
+full, or breaks a match first, is dropped. A stream ends before a run
+of "CARVE_RUN" bytes the same [padding], a block the scan looks for,
+or a broken match; it must decode to "LZ_MIN" bytes or more, and to
+more than it takes.
+
+Streams are handed on as Yaz0 blocks, with a header made for them, and
+named by the offset of the stream itself.
+---------------------------------------------------------------------*/
+#define CARVE_WINDOW 0x1000U
+#define CARVE_RUN    8U
+
+static struct
+{
+  u32    bits;    /* Evidence a stream must have */
+  double density; /* Bits per byte of the chunks tried */
+}
+carving = { 40, 4.0 };
+
+
+
+/*-----------------------------------------------------------
+Evidence of a match fitting within the "written" bytes decoded
+so far: 12 bits, less log2 of "written" rounded up, so that it
+never claims better odds than a random distance would have.
+-----------------------------------------------------------*/
+static u32 _getEvidence( const u32 written )
+{
+  u32 bits  = 12;
+  u32 reach = 1;
+
+  while ( reach < written )
+  {
+    reach <<= 1;
+    --bits;
+  }
+
+  return bits;
+}
+
+
+
+static int _isCarveEnd( const u8 *srcbuf, const u32 at, const u32 limit,
+                        const u32 xr, const unsigned isGroup )
+{
+  u32 fill = _peek8( srcbuf, at, xr );
+  u32 i    = 1;
+
+  if ( (at + CARVE_RUN) <= limit )
+  {
+    while ( (i < CARVE_RUN) && (_peek8( srcbuf, at + i, xr ) == fill) )
+    {
+      ++i;
+    }
+
+    if ( i == CARVE_RUN )
+    {
+      return 1;
+    }
+  }
+
+  /*-----------------------------------------------------
+  Only where a flag byte would be read; any other byte of
+  a token may happen to be the lead of a FourCC.
+  -----------------------------------------------------*/
+  if ( (isGroup != 0) && (leads[fill] != 0) && ((at + 4U) <= limit) )
+  {
+    const struct format *format =
+      _getCandidate( leads[fill], _peek32( srcbuf, at, xr ) );
+
+    return (format != (const struct format *)0) && (format->signature != 0);
+  }
+
+  return 0;
+}
+
+
+
+/*-------------------------------------------------------------------
+Walks a headerless Yaz0 stream at "position" of "srcbuf", in the byte
+order "xr", up to "limit". Returns its length, with "*sizeDecoded" and
+"*bits" of evidence for it, or 0 where there's no stream to be had.
+-------------------------------------------------------------------*/
+static u32 _trialCarve( const u8 *srcbuf, const u32 position,
+                        const u32 limit, const u32 xr,
+                        u32 *sizeDecoded, u32 *bits )
+{
+  u32 at      = position;
+  u32 group   = position;
+  u32 written = 0;
+  u32 flags   = 0;
+  u32 masks   = 0;
+  u32 length;
+  u32 distance;
+  u32 next;
+
+  *bits = 0;
+
+  while ( (at < limit) && (written < 0x3FFFFFFFU) )
+  {
+    if ( _isCarveEnd( srcbuf, at, limit, xr, (masks == 0) ) )
+    {
+      break;
+    }
+
+    if ( masks == 0 )
+    {
+      group = at;
+      flags = _peek8( srcbuf, at++, xr );
+      masks = 8U;
+      continue;
+    }
+
+    if ( (flags & 0x80U) != 0 )
+    {
+      ++at;
+      ++written;
+    }
+    else
+    {
+      if ( (at + 2U) > limit )
+      {
+        break;
+      }
+
+      length   = _peek8( srcbuf, at, xr ) >> 4;
+      distance = (((_peek8( srcbuf, at, xr ) & 0x0FU) << 8) |
+                  _peek8( srcbuf, at + 1U, xr )) + 1U;
+      next     = at + 2U;
+
+      if ( length == 0 )
+      {
+        if ( (at + 3U) > limit )
+        {
+          break;
+        }
+
+        length = _peek8( srcbuf, at + 2U, xr ) + 0x12U;
+        next   = at + 3U;
+      }
+      else
+      {
+        length += 2U;
+      }
+
+      if ( distance > written )
+      {
+        break;
+      }
+
+      if ( written < CARVE_WINDOW )
+      {
+        *bits += _getEvidence( written );
+      }
+
+      written += length;
+      at       = next;
+    }
+
+    flags <<= 1;
+    --masks;
+
+    if ( (written >= CARVE_WINDOW) && (*bits < carving.bits) )
+    {
+      return 0;
+    }
+  }
+
+  /*-----------------------------------------------
+  A flag byte with none of its tokens taken isn't
+  part of the stream.
+  -----------------------------------------------*/
+  if ( masks == 8U )
+  {
+    at = group;
+  }
+
+  if (    (*bits < carving.bits) || (written < LZ_MIN)
+       || ((at - position) >= written) )
+  {
+    return 0;
+  }
+
+  *sizeDecoded = written;
+  return at - position;
+}
+
+
+
+/*--------------------------------------------------------------------
+Of chunk "chunk" of the region map, whether its offsets are tried.
+--------------------------------------------------------------------*/
+static int _probeChunk( const u8 *srcbuf, const u32 lengthROM,
+                        const u32 chunk, const u8 *regions )
+{
+  u32 start = chunk << REGION_SHIFT;
+  u32 length;
+
+  if ( start >= lengthROM )
+  {
+    return 0;
+  }
+
+  if (    (regions != (const u8 *)0)
+       && (regions[chunk] == REGION_UNIFORM) )
+  {
+    return 0;
+  }
+
+  length = ((lengthROM - start) < REGION_SIZE) ?
+           (lengthROM - start) : REGION_SIZE;
+
+  /*--------------------------------------------------------
+  Swizzling keeps bytes within their word, so a chunk has
+  the same entropy in any byte order.
+  --------------------------------------------------------*/
+  return _getEntropy( &srcbuf[start], length ) >= carving.density;
+}
+
+
+
+/*---------------------------------------------------------------------
+Run at the end of "scanSLI" at depth 0, with the same arguments. The
+blocks it found are stepped over by measuring them again, as is any
+stream carved.
+---------------------------------------------------------------------*/
+static void _carveSLI( u8 *srcbuf, const u32 lengthROM, const u32 fourCC,
+                       const u32 xr, const char *gameID,
+                       const char *gameName, const char *path,
+                       struct tally *tally )
+{
+  u32 position = 0;
+  u32 window   = (filter.isWindowed != 0) ? 0 : lengthROM;
+  u32 chunk    = 0xFFFFFFFFU;
+  int isDense  = 0;
+  int isNext   = 0;
+
+  while ( (position + 0x10U) <= lengthROM )
+  {
+    const struct format *format;
+    u32 kinds;
+    u32 start;
+    u32 blockLength;
+    u32 sizeDecoded;
+    u32 bits;
+    u8 *block;
+
+    if ( position >= window )
+    {
+      if ( _nextWindow( &position, &window ) == 0 )
+      {
+        break;
+      }
+
+      position = (position + 3U) & ~3U;
+      continue;
+    }
+
+    if ( _peek32( srcbuf, position, xr ) == CMPR )
+    {
+      blockLength = _peek32( srcbuf, position + 4U, xr );
+
+      if ( (blockLength >= 0x20U) && (blockLength <= (lengthROM - position)) )
+      {
+        position = (position + blockLength + 3U) & ~3U;
+        continue;
+      }
+    }
+
+    if ( (kinds = leads[_peek8( srcbuf, position, xr )]) != 0 )
+    {
+      format = _getCandidate( kinds, _peek32( srcbuf, position, xr ) );
+
+      if (    (format != (const struct format *)0)
+           && (format->measure( srcbuf, position, lengthROM, xr,
+                                format->kernel, &blockLength,
+                                (struct shape *)0 ) == EXIT_SUCCESS) )
+      {
+        position = (position + blockLength + 3U) & ~3U;
+        continue;
+      }
+    }
+
+    if ( (position >> REGION_SHIFT) != chunk )
+    {
+      isDense = ((position >> REGION_SHIFT) == (chunk + 1U)) ?
+                isNext :
+                _probeChunk( srcbuf, lengthROM, position >> REGION_SHIFT,
+                             tally->regions );
+      chunk   = position >> REGION_SHIFT;
+      isNext  = _probeChunk( srcbuf, lengthROM, chunk + 1U,
+                             tally->regions );
+    }
+
+    if (    ((isDense | isNext) == 0)
+         || ((blockLength = _trialCarve( srcbuf, position, lengthROM, xr,
+                                         &sizeDecoded, &bits )) == 0) )
+    {
+      position += 4U;
+      continue;
+    }
+
+    start = position;
+
+    if (    ((filter.formats & FMT_YAZ) == 0)
+         || !_isBounded( blockLength + 0x10U, filter.raw )
+         || !_isBounded( sizeDecoded, filter.decoded ) )
+    {
+      ++tally->filtered;
+      position = (start + blockLength + 3U) & ~3U;
+      continue;
+    }
+
+    if ( options.verbose != 0 )
+    {
+      fprintf( STATUS, "# Carved 0x%X: %u bytes to %u, %u bits\n",
+                       start, blockLength, sizeDecoded, bits );
+    }
+
+    if ( (block = (u8 *)_poolGet( tally->pool, POOL_BLOCK, 0,
+                                  blockLength + 0x10U )) == (u8 *)0 )
+    {
+      return;
+    }
+
+    memset( block, 0, 0x10U );
+    *(u32 *)&block[0x00U] = _swap32( Yaz );
+    *(u32 *)&block[0x04U] = _swap32( sizeDecoded );
+    _unswizzle( &block[0x10U], srcbuf, start, blockLength, xr );
+    ++tally->carved;
+
+    if ( options.listMode != 0 )
+    {
+      listSLI( block, 0, 0, start, blockLength + 0x10U,
+               Yaz, path, 0, tally );
+    }
+    else
+    {
+      if ( options.emitMode != 0 )
+      {
+        emitSLI( block, &position, blockLength + 0x10U, tally, Yaz, 0 );
+      }
+      else
+      {
+        writeSLI( block, &position, blockLength + 0x10U,
+                  tally, fourCC, Yaz, gameID, gameName, path, 0, 0 );
+      }
+
+      if ( position == 0 )
+      {
+        return;
+      }
+    }
+
+    position = (start + blockLength + 3U) & ~3U;
+  }
+
+  return;
+}
+
+
+
+/*------------------------------------------------------------------
+"depth" is zero for a ROM, and counts the levels of decoded blocks
+above "srcbuf" when it is called upon to scan nested data.
+"xr" is non-zero for an N64 ROM that was left in its original byte
+ordering; only the blocks found are then put into Big-Endian order.
+------------------------------------------------------------------*/
+static void scanSLI( u8 *srcbuf,
+                     const u32 lengthROM, const u32 fourCC, const u32 xr,
+                     const char *path, const u32 depth,
+                     struct tally *tally )
+{
+  /*----------------------
+  FourCC + NULL Terminator
+  ----------------------*/
+  char gameID[5];
+  /*-----------------------------
+  20 Byte Frame + NULL Terminator
+  -----------------------------*/
+  char gameName[21];
+  u32 magic = 0;
+  u32 id32  = 0;
+  u32 blockLength = 0;
+  u32 position = 0;
+  u32 window   = ((depth == 0) && (filter.isWindowed != 0)) ? 0 : lengthROM;
+  u8 *block   = (u8 *)0;
+  unsigned hasGZIP = 0;
+  u32 kinds;
+#ifdef XSLI_METRICS
+  int slot;
+#endif
+  int measured;
+  const struct format *format;
+  const struct quirk *quirk;
+  /*-----------------------------------------------------------
+  Set once per ROM; titles without an entry in "quirks" take no
+  title-specific branches for any of their candidates.
+  -----------------------------------------------------------*/
+  unsigned isPlain;
+
+  METER_ADD( scanned, lengthROM );
+
+  if ( fourCC != 0 )
+  {
+    id32 = _peek32( srcbuf, 0x3BU, xr );
+  }
+
+  quirk   = _getQuirk( id32 );
+  isPlain = (quirk->id[0] == 0);
+  hasGZIP = (quirk->prefix == 0);
+
+  if ( (isPlain == 0) && (options.verbose != 0) && (depth == 0) )
+  {
+    fprintf( STATUS, "# Quirk Profile: %s\n", quirk->title );
+  }
+
+  if ( (fourCC != 0) && (options.useGameName != 0) )
+  {
+    int j = 0;
+
+    while ( j < 4 )
+    {
+      gameID[j] = (char)_peek8( srcbuf, 0x3BU + j, xr );
+      ++j;
+    }
+
+    gameID[j] = '\0';
+    j = 0;
+
+    while ( j < 20 )
+    {
+      gameName[j] = (char)_peek8( srcbuf, 0x20U + j, xr );
+
+      if ( j < 19 )
+      {
+        if ( (gameName[j] == ' ') && (gameName[j + 1] != ' ') )
+        {
+          gameName[j] = '_';
+        }
+
+        if ( ((_peek8( srcbuf, 0x20U + j,      xr ) == 0x20U) &&
+              (_peek8( srcbuf, 0x20U + j + 1U, xr ) == 0x20U)) )
+        {
+          goto space;
+        }
+      }
+      else
+      {
+space:  gameName[j] = '\0';
+        break;
+      }
+
+      ++j;
+    }
+  }
+
+  while ( (position + 0x10U) <= lengthROM )
+  {
+    if ( position >= window )
+    {
+      if ( _nextWindow( &position, &window ) == 0 )
+      {
+        break;
+      }
+
+      continue;
+    }
+
+    /*---------------------------------------------------------------
+    Only the leading byte is checked in place before assembling a
+    whole FourCC, from swizzled bytes or not; see "_buildLeads".
+    ---------------------------------------------------------------*/
+    if ( (kinds = leads[_peek8( srcbuf, position, xr )]) == 0 )
+    {
+      goto next;
+    }
+
+    magic  = _peek32( srcbuf, position, xr );
+    format = _getCandidate( kinds, magic );
+
+    if ( format != (const struct format *)0 )
+    {
+#ifdef XSLI_METRICS
+      slot  = (int)(format - formats);
+#endif
+      magic = format->magic;
+      METER_ADD( candidates[slot], 1 );
+
+      /*------------------------------------------------------
+      A block left out is still measured, and stepped over, so
+      that its data isn't scanned as if it held blocks itself.
+      ------------------------------------------------------*/
+      if ( (filter.formats & format->bit) == 0 )
+      {
+        if ( format->measure( srcbuf, position, lengthROM, xr,
+                              format->kernel, &blockLength,
+                              (struct shape *)0 ) == EXIT_SUCCESS )
+        {
+          ++tally->filtered;
+          METER_ADD( filtered[slot], 1 );
+          position += blockLength;
+          continue;
+        }
+
+        goto next;
+      }
+
+      if ( isPlain == 0 )
+      {
+        if ( (quirk->formats & format->bit) == 0 )
+        {
+          goto next;
+        }
+
+        if ( (position & quirk->alignment) != 0 )
+        {
+          ++tally->oddities;
+          METER_ADD( rejects[slot], 1 );
+
+          if ( options.verbose != 0 )
+          {
+            postDiscrepancy( srcbuf, xr, position, tally->oddities );
+          }
+
+          goto next;
+        }
+      }
+
+      if ( magic == MIO )
+      {
+        if ( quirk->header == 0x14U )
+        {
+          u32 walked;
+
+          /*----------------------------------------------------
+          DMA Design Limited [a.k.a. Rockstar North] used a
+          non-standard SLI header in their title "Body Harvest".
+          Instead of using the standard 16-Byte header,
+          they used a 20-Byte header that deviates as such:
+
+          MM = Magic, DD = DecodedSize,
+          PP = Offset to Pointers, RR = Offset to Raw Bytes
+
+          MMMMMMMM BLOCKLEN DDDDDDDD PPPPPPPP
+          RRRRRRRR
+          ----------------------------------------------------*/
+          blockLength = _peek32( srcbuf, position + 4U, xr ) - 4U;
+
+          if (    ((position + 0x14U) > lengthROM)
+               || (blockLength < 0x10U)
+               || (blockLength > (lengthROM - position - 4U)) )
+          {
+            METER_ADD( rejects[slot], 1 );
+            goto next;
+          }
+
+          position += 4U;
+
+          /*----------------------------------------------------
+          Always a copy, so that the ROM itself is never patched.
+          ----------------------------------------------------*/
+          if ( (block = (u8 *)_poolGet( tally->pool, POOL_BLOCK, depth,
+                                        blockLength )) == (u8 *)0 )
+          {
+            return;
+          }
+
+          _unswizzle( block, srcbuf, position, blockLength, xr );
+          _patchHeader( block, magic );
+
+          /*----------------------------------------------------
+          Walked as any other "MIO0" is, now that its header is
+          standard, before "decbuf" is trusted with it.
+          ----------------------------------------------------*/
+          if ( getBlockLength( block, 0, blockLength, 0, magic,
+                               &walked, (struct shape *)0 ) != EXIT_SUCCESS )
+          {
+            ++tally->oddities;
+            METER_ADD( rejects[slot], 1 );
+
+            if ( options.verbose != 0 )
+            {
+              postDiscrepancy( srcbuf, xr, position, tally->oddities );
+            }
+
+            goto next;
+          }
+
+          if (    !_isBounded( blockLength, filter.raw )
+               || !_isBounded( _peek32( block, 0x04U, 0 ),
+                               filter.decoded ) )
+          {
+            ++tally->filtered;
+            METER_ADD( filtered[slot], 1 );
+            position += blockLength;
+            goto next;
+          }
+
+          if ( tally->shape != (struct shape *)0 )
+          {
+            _takeShape( block, position, depth, magic, blockLength,
+                        _peek32( block, 0x04U, 0 ), tally->pool );
+          }
+
+          if (    (options.listMode != 0)
+               || (tally->index != (struct index *)0) )
+          {
+            listSLI( block, 0, 0, position, blockLength,
+                     magic, path, depth, tally );
+            position += blockLength;
+          }
+          else if ( options.emitMode != 0 )
+          {
+            emitSLI( block, &position, blockLength, tally, magic, depth );
+          }
+          else
+          {
+            writeSLI( block, &position, blockLength,
+                      tally, fourCC, magic,
+                      gameID, gameName, path, depth, 0 );
+          }
+
+          if ( position == 0 )
+          {
+            return;
+          }
+
+          goto next;
+        }
+        else
+        {
+          /*------------------------------------------------------------
+          Once a "MIO0" preceded by the profile's prefix has been seen,
+          any later "MIO0" without it is treated as a discrepancy.
+          See the "Duck Dodgers" entry in "quirks".
+          ------------------------------------------------------------*/
+          u32 code = (position >= 0x10U) ?
+                     _peek32( srcbuf, position - 0x10U, xr ) : 0;
+
+          if ( !hasGZIP && (code == quirk->prefix) )
+          {
+            hasGZIP = !hasGZIP;
+          }
+          else
+          {
+            if ( hasGZIP && (quirk->prefix != 0) && (code != quirk->prefix) )
+            {
+              ++tally->oddities;
+              METER_ADD( rejects[slot], 1 );
+
+              if ( options.verbose != 0 )
+              {
+                postDiscrepancy( srcbuf, xr, position, tally->oddities );
+              }
+
+              goto next;
+            }
+          }
+        }
+      }
+      /*------------------------------------------------
+      Function returns "0" on success, and "1" on error.
+      "blockLength" is the true recipient variable
+      pertaining to the function's implicit descriptor.
+      ------------------------------------------------*/
+      if ( tally->shape != (struct shape *)0 )
+      {
+        memset( tally->shape, 0, sizeof(*tally->shape) );
+      }
+
+      TRACE_BEGIN( TRACE_LENGTH, position, magic );
+      measured = format->measure( srcbuf, position, lengthROM, xr,
+                                  format->kernel, &blockLength,
+                                  tally->shape );
+      TRACE_END( TRACE_LENGTH, position, magic );
+
+      if ( measured == MEASURE_NONE )
+      {
+        METER_ADD( rejects[slot], 1 );
+        goto next;
+      }
+
+      if ( measured == EXIT_SUCCESS )
+      {
+        /*--------------------------------------------------------
+        Sizes are filtered once the block is measured, so that a
+        header giving an absurd one is counted as an oddity, and
+        a block left out is stepped over whole.
+        --------------------------------------------------------*/
+        if (    !_isBounded( blockLength, filter.raw )
+             || !_isBounded( format->getSize( srcbuf, position, xr ),
+                             filter.decoded ) )
+        {
+          ++tally->filtered;
+          METER_ADD( filtered[slot], 1 );
+          position += blockLength;
+          continue;
+        }
+
+        if ( tally->shape != (struct shape *)0 )
+        {
+          _putShape( position, depth, magic, blockLength,
+                     format->getSize( srcbuf, position, xr ) );
+        }
+
+        if ( (options.listMode != 0) || (tally->index != (struct index *)0) )
+        {
+          listSLI( srcbuf, position, xr, position, blockLength,
+                   magic, path, depth, tally );
+          position += blockLength;
+          continue;
+        }
+
+        if ( (block = _getBlock( srcbuf, position, blockLength,
+                                 xr, tally->pool, depth )) == (u8 *)0 )
+        {
+          return;
+        }
+
+        if ( options.emitMode != 0 )
+        {
+          emitSLI( block, &position, blockLength, tally, magic, depth );
+        }
+        else
+        {
+          writeSLI( block, &position, blockLength,
+                    tally, fourCC, magic,
+                    gameID, gameName, path, depth,
+                    (xr == 0) && (depth == 0) );
+        }
+
+        if ( position == 0 )
+        {
+          return;
+        }
+      }
+      else
+      {
+        ++tally->oddities;
+        METER_ADD( rejects[slot], 1 );
+
+        if ( options.verbose != 0 )
+        {
+          postDiscrepancy( srcbuf, xr, position, tally->oddities );
+        }
+
+        position += 4U;
+      }
+    }
+    else
+    {
+      if (    (magic == CMPR) && ((position + 0x14U) <= lengthROM)
+           && ((isPlain != 0) || ((quirk->formats & FMT_CMPR) != 0)) )
+      {
+        METER_ADD( candidates[_getFormatSlot( magic )], 1 );
+        magic = _peek32( srcbuf, position + 0x10U, xr );
+        blockLength = _peek32( srcbuf, position + 0x04U, xr );
+
+        if (    (magic == SMSR) && (blockLength >= 0x20U)
+             && (blockLength <= (lengthROM - position)) )
+        {
+          if ( _walkSMSR( srcbuf, position, blockLength, xr ) != EXIT_SUCCESS )
+          {
+            ++tally->oddities;
+            METER_ADD( rejects[_getFormatSlot( magic )], 1 );
+
+            if ( options.verbose != 0 )
+            {
+              postDiscrepancy( srcbuf, xr, position, tally->oddities );
+            }
+
+            goto next;
+          }
+
+          if (    ((filter.formats & FMT_CMPR) == 0)
+               || !_isBounded( blockLength, filter.raw )
+               || !_isBounded( _peek32( srcbuf, position + 0x08U, xr ),
+                               filter.decoded ) )
+          {
+            ++tally->filtered;
+            METER_ADD( filtered[_getFormatSlot( magic )], 1 );
+            position += blockLength;
+            continue;
+          }
+
+          if ( tally->shape != (struct shape *)0 )
+          {
+            if ( (block = _getBlock( srcbuf, position, blockLength,
+                                     xr, tally->pool, depth )) == (u8 *)0 )
+            {
+              return;
+            }
+
+            _takeShape( block, position, depth, magic, blockLength,
+                        _peek32( srcbuf, position + 0x08U, xr ),
+                        tally->pool );
+          }
+
+          if (    (options.listMode != 0)
+               || (tally->index != (struct index *)0) )
+          {
+            listSLI( srcbuf, position, xr, position, blockLength,
+                     magic, path, depth, tally );
+            position += blockLength;
+            continue;
+          }
+
+          if ( (block = _getBlock( srcbuf, position, blockLength,
+                                   xr, tally->pool, depth )) == (u8 *)0 )
+          {
+            return;
+          }
+
+          if ( options.emitMode != 0 )
+          {
+            emitSLI( block, &position, blockLength, tally, magic, depth );
+          }
+          else
+          {
+            writeSLI( block, &position, blockLength,
+                      tally, fourCC, magic,
+                      gameID, gameName, path, depth,
+                      (xr == 0) && (depth == 0) );
+          }
+
+          if ( position == 0 )
+          {
+            return;
+          }
+        }
+        else
+        {
+          METER_ADD( rejects[_getFormatSlot( CMPR )], 1 );
+          goto next;
+        }
+      }
+      else
+      {
+next:   ++position;
+
+        /*-------------------------------------------------------
+        Entering a chunk of padding; see "_mapRegions".
+        -------------------------------------------------------*/
+        if (    ((position & (REGION_SIZE - 1U)) == 0)
+             && (depth == 0) && (tally->regions != (const u8 *)0)
+             && (tally->regions[position >> REGION_SHIFT] == REGION_UNIFORM)
+             && ((lengthROM - position) >= REGION_SIZE) )
+        {
+          tally->skipped += REGION_SIZE - 3U;
+          position       += REGION_SIZE - 3U;
+        }
+      }
+    }
+  }
+
+  if (    (options.carve != 0) && (depth == 0)
+       && (tally->index == (struct index *)0) )
+  {
+    _carveSLI( srcbuf, lengthROM, fourCC, xr,
+               gameID, gameName, path, tally );
+  }
+
+  return;
+}
+
+
+
+struct check
+{
+  u32 verdict;
+  u32 crc;
+};
+
+/*-------------------------------------------------------------
+Shared by the workers of "verifySLI", which take blocks in turn
+from "next" until every one of the index has been checked.
+-------------------------------------------------------------*/
+struct checkRun
+{
+  u8 *srcbuf;
+  u32 xr;
+  const struct quirk *quirk;
+  const struct index *index;
+  struct check *checks;
+  u32 next;
+};
+
+
+
+static void *_checkBlocks( void *argument )
+{
+  struct checkRun *run = (struct checkRun *)argument;
+  struct pool pool;
+  u32 i;
+
+  memset( &pool, 0, sizeof(pool) );
+
+  while ( (i = __sync_fetch_and_add( &run->next, 1U )) < run->index->count )
+  {
+    const struct hit *hit = &run->index->hits[i];
+    struct check *check   = &run->checks[i];
+    u8 *block = _getHitBlock( run->srcbuf, run->xr, run->quirk, hit, &pool );
+    u8 *dst   = (u8 *)0;
+
+    check->crc = 0;
+
+    if ( (hit->decoded == 0) || (hit->decoded >= 0x3FFFFFFFU) )
+    {
+      check->verdict = VERIFY_HEADER;
+      continue;
+    }
+
+    if (    (block == (u8 *)0)
+         || ((dst = (u8 *)_poolGet( &pool, POOL_DECODED, 0, hit->decoded ))
+             == (u8 *)0) )
+    {
+      check->verdict = VERIFY_MEMORY;
+      continue;
+    }
+
+    TRACE_BEGIN( TRACE_DECODE, hit->offset, hit->magic );
+    check->verdict = (u32)_checkBlock( block, hit->raw, hit->magic,
+                                       dst, hit->decoded,
+                                       (struct shape *)0 );
+    TRACE_END( TRACE_DECODE, hit->offset, hit->magic );
+
+    if ( check->verdict == VERIFY_OK )
+    {
+      check->crc = _crc32( dst, 0, hit->decoded, 0 );
+      METER_ADD( decoded, hit->decoded );
+    }
+  }
+
+  _poolFree( &pool );
+  return (void *)0;
+}
+
+
+
+/*-------------------------------------------------------------------
+Indexes the blocks at the top level of a ROM with "scanSLI", as "-u"
+does, then checks them across "-j" threads where there are any. One
+record is printed per block in the order of the ROM; a failure of
+any block fails the ROM. Candidates the scan itself rejects are only
+counted, as "Oddities", as they would be otherwise.
+-------------------------------------------------------------------*/
+static int verifySLI( u8 *srcbuf, const u32 lengthROM, const u32 fourCC,
+                      const u32 xr, struct tally *tally )
+{
+  struct index index;
+  struct checkRun run;
+  u32 failed = 0;
+  u32 i;
+
+  memset( &index, 0, sizeof(index) );
+  tally->index = &index;
+  scanSLI( srcbuf, lengthROM, fourCC, xr, "", (u32)0, tally );
+  tally->index = (struct index *)0;
+
+  if ( index.isTruncated != 0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to allocate for the block index!\n\n" );
+    free( index.hits );
+    return EXIT_FAILURE;
+  }
+
+  run.srcbuf = srcbuf;
+  run.xr     = xr;
+  run.quirk  = _getQuirk( (fourCC != 0) ? _peek32( srcbuf, 0x3BU, xr ) : 0 );
+  run.index  = &index;
+  run.next   = 0;
+  run.checks = (struct check *)malloc( sizeof(struct check) *
+                                       (index.count + 1U) );
+
+  if ( run.checks == (struct check *)0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to allocate for the block checks!\n\n" );
+    free( index.hits );
+    return EXIT_FAILURE;
+  }
+
+#ifdef XSLI_THREADS
+  {
+    pthread_t workers[THREADS_MAX];
+    u32 count   = (threads < index.count) ? threads : index.count;
+    u32 started = 0;
+
+    while (    (started < count)
+            && (pthread_create( &workers[started], (const pthread_attr_t *)0,
+                                _checkBlocks, &run ) == 0) )
+    {
+      ++started;
+    }
+
+    /*---------------------------------------------------------
+    Whatever wasn't taken by a worker is checked here, so that
+    a failure to start any of them only costs the parallelism.
+    ---------------------------------------------------------*/
+    _checkBlocks( &run );
+
+    while ( started != 0 )
+    {
+      pthread_join( workers[--started], (void **)0 );
+    }
+  }
+#else
+  _checkBlocks( &run );
+#endif
+
+  for ( i = 0; i < index.count; ++i )
+  {
+    const struct hit *hit = &index.hits[i];
+    char name[16];
+
+    sprintf( name, "0x%X", hit->offset );
+
+    if ( run.checks[i].verdict == VERIFY_OK )
+    {
+      printf( "%-24s %s %10u %10u  %08X  %s\n",
+              name, _getFormatName( hit->magic ), hit->raw, hit->decoded,
+              run.checks[i].crc, verdicts[VERIFY_OK] );
+    }
+    else
+    {
+      printf( "%-24s %s %10u %10u  --------  %s\n",
+              name, _getFormatName( hit->magic ), hit->raw, hit->decoded,
+              verdicts[run.checks[i].verdict] );
+      ++failed;
+    }
+  }
+
+  fprintf( STATUS, "# Verified: %u\n# Failed: %u\n# Oddities: %u\n",
+                   index.count - failed, failed, tally->oddities );
+  free( run.checks );
+  free( index.hits );
+  return (failed != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+/*---------------------------------------------------------------------
+"--unpack" decodes files that are a single block each, as ".szs",
+".szp" and ".lz" files are, from the header at their very start:
+nothing is scanned, and nothing but the decoded data is written. Each
+is decoded with the checks of "--verify", save that any padding past
+the end of the block is let be. Files are taken in turn by "-j" threads; output
+to stdout is still written in the order the files were given.
+---------------------------------------------------------------------*/
+struct unpackRun
+{
+  const char **paths;
+  const char *dest;
+  u32 count;
+  u32 next;
+  u32 failed;
+  /*-----------------------------------------------------------
+  With stdout as "dest", the index of the file written next,
+  which every other worker holding decoded data waits for.
+  -----------------------------------------------------------*/
+  u32 turn;
+#ifdef XSLI_THREADS
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+#endif
+};
+
+
+
+/*-------------------------------------------------------------------
+The decoded file's path: "dest" itself for a single file, or within
+the directory "dest" for several, else beside the file. Its name is
+that of the file without ".szs", ".szp" or ".lz", or with ".dec"
+added when it has none of them. Returns non-zero if the path is too
+long.
+-------------------------------------------------------------------*/
+static int _getUnpackPath( const char *path, const char *dest,
+                           const u32 count, char *unpackPath )
+{
+  const char *name = path;
+  size_t length;
+
+  if ( (dest != (const char *)0) && (count == 1U) )
+  {
+    if ( strlen( dest ) >= FILENAME_MAX )
+    {
+      return 1;
+    }
+
+    strcpy( unpackPath, dest );
+    return 0;
+  }
+
+  if ( dest != (const char *)0 )
+  {
+    const char *slash = strrchr( path, '/' );
+
+    name = (slash != (const char *)0) ? (slash + 1) : path;
+  }
+
+  length = strlen( name );
+
+  if (    (length > 4U) && (name[length - 4U] == '.')
+       && (toupper( (unsigned char)name[length - 3U] ) == 'S')
+       && (toupper( (unsigned char)name[length - 2U] ) == 'Z')
+       && (    (toupper( (unsigned char)name[length - 1U] ) == 'S')
+            || (toupper( (unsigned char)name[length - 1U] ) == 'P') ) )
+  {
+    length -= 4U;
+  }
+  else if (    (length > 3U) && (name[length - 3U] == '.')
+            && (toupper( (unsigned char)name[length - 2U] ) == 'L')
+            && (toupper( (unsigned char)name[length - 1U] ) == 'Z') )
+  {
+    length -= 3U;
+  }
+
+  if ( (((dest != (const char *)0) ? strlen( dest ) : 0) + length + 6U)
+       >= FILENAME_MAX )
+  {
+    return 1;
+  }
+
+  unpackPath[0] = '\0';
+
+  if ( dest != (const char *)0 )
+  {
+    sprintf( unpackPath, "%s/", dest );
+  }
+
+  strncat( unpackPath, name, length );
+
+  if ( length == strlen( name ) )
+  {
+    strcat( unpackPath, ".dec" );
+  }
+
+  return 0;
+}
+
+
+
+/*-----------------------------------------------------------------
+Decodes the file at "path" into "unpackPath", or into "*dst" from
+"pool" when writing to stdout, setting "*sizeDecoded". Returns a
+"verdicts" index, or VERIFY_KINDS for a file that can't be read.
+-----------------------------------------------------------------*/
+static u32 _unpackFile( const char *path, const char *unpackPath,
+                        struct pool *pool, u8 **dst, u32 *sizeDecoded )
+{
+  FILE *IN  = (FILE *)0;
+  FILE *OUT = (FILE *)0;
+  u8  *block;
+  u8  *mapped = (u8 *)0;
+  u32  blockLength;
+  u32  lengthRead;
+  u32  magic;
+  const struct format *format;
+  u32  verdict;
+
+  *dst = (u8 *)0;
+  *sizeDecoded = 0;
+
+  if ( (IN = fopen( path, "rb" )) == (FILE *)0 )
+  {
+    return VERIFY_KINDS;
+  }
+
+  fseek( IN, 0L, SEEK_END );
+  blockLength = (u32)ftell( IN );
+
+  if ( (blockLength == (u32)EOF) || (blockLength >= 0x3FFFFFFF) )
+  {
+    fclose( IN );
+    return VERIFY_KINDS;
+  }
+
+  if ( blockLength < 0x10U )
+  {
+    fclose( IN );
+    return VERIFY_HEADER;
+  }
+
+  if ( (block = (u8 *)_poolGet( pool, POOL_ROM, 0, blockLength )) == (u8 *)0 )
+  {
+    fclose( IN );
+    return VERIFY_MEMORY;
+  }
+
+  rewind( IN );
+  TRACE_BEGIN( TRACE_LOAD, 0, 0 );
+  lengthRead = (u32)fread( block, sizeof(u8), blockLength, IN );
+  TRACE_END( TRACE_LOAD, 0, 0 );
+  fclose( IN );
+
+  if ( lengthRead != blockLength )
+  {
+    return VERIFY_KINDS;
+  }
+
+  magic = _peek32( block, 0, 0 );
+
+  format = _getFormatInfo( magic );
+
+  /*-------------------------------------------------------------
+  Formats without a FourCC are told apart by the leading byte,
+  whether or not "-f" asked for them; CMPR must wrap an SMSR00.
+  -------------------------------------------------------------*/
+  if ( format == &formats[FORMAT_SLOTS] )
+  {
+    if ( (magic >> 24) == formats[FORMAT_LZ10].lead )
+    {
+      format = &formats[FORMAT_LZ10];
+    }
+    else if ( (magic >> 24) == formats[FORMAT_LZ11].lead )
+    {
+      format = &formats[FORMAT_LZ11];
+    }
+    else
+    {
+      return VERIFY_HEADER;
+    }
+  }
+  else if (    (format->magic == SMSR)
+            && (    (magic != CMPR) || (blockLength < 0x20U)
+                 || (_peek32( block, 0x10U, 0 ) != SMSR) ) )
+  {
+    return VERIFY_HEADER;
+  }
+
+  magic = format->magic;
+  *sizeDecoded = format->getSize( block, (u32)0, (u32)0 );
+
+  if ( (*sizeDecoded == 0) || (*sizeDecoded >= 0x3FFFFFFFU) )
+  {
+    return VERIFY_HEADER;
+  }
+
+  if ( unpackPath != (const char *)0 )
+  {
+    if ( (OUT = fopen( unpackPath, "w+b" )) == (FILE *)0 )
+    {
+      return VERIFY_KINDS;
+    }
+
+#ifdef XSLI_ZEROCOPY
+    if ( *sizeDecoded >= MAP_MIN )
+    {
+      *dst = mapped = _mapDecoded( OUT, *sizeDecoded );
+    }
+#endif
+  }
+
+  if ( *dst == (u8 *)0 )
+  {
+    *dst = (u8 *)_poolGet( pool, POOL_DECODED, 0, *sizeDecoded );
+  }
+
+  if ( *dst == (u8 *)0 )
+  {
+    verdict = VERIFY_MEMORY;
+  }
+  else
+  {
+    TRACE_BEGIN( TRACE_DECODE, 0, magic );
+    verdict = (u32)_checkBlock( block, blockLength, magic,
+                                *dst, *sizeDecoded, (struct shape *)0 );
+    TRACE_END( TRACE_DECODE, 0, magic );
+
+    if ( verdict == VERIFY_LENGTH )
+    {
+      verdict = VERIFY_OK;
+    }
+  }
+
+  if ( verdict == VERIFY_OK )
+  {
+    METER_ADD( decoded, *sizeDecoded );
+  }
+
+  if ( OUT != (FILE *)0 )
+  {
+    TRACE_BEGIN( TRACE_WRITE, 0, magic );
+
+    if ( (verdict == VERIFY_OK) && (mapped == (u8 *)0) )
+    {
+      fwrite( *dst, sizeof(u8), *sizeDecoded, OUT );
+    }
+
+#ifdef XSLI_ZEROCOPY
+    if ( mapped != (u8 *)0 )
+    {
+      if (    (verdict == VERIFY_OK)
+           && (msync( mapped, (size_t)*sizeDecoded, MS_SYNC ) != 0) )
+      {
+        verdict = VERIFY_KINDS;
+      }
+
+      munmap( mapped, (size_t)*sizeDecoded );
+    }
+#endif
+
+    if ( (fclose( OUT ) != 0) && (verdict == VERIFY_OK) )
+    {
+      verdict = VERIFY_KINDS;
+    }
+
+    TRACE_END( TRACE_WRITE, 0, magic );
+
+    if ( verdict != VERIFY_OK )
+    {
+      remove( unpackPath );
+    }
+    else
+    {
+      METER_ADD( written, *sizeDecoded );
+    }
+
+    *dst = (u8 *)0;
+  }
+
+  return verdict;
+}
+
+
+
+static void *_unpackFiles( void *argument )
+{
+  struct unpackRun *run = (struct unpackRun *)argument;
+  struct pool pool;
+  char unpackPath[FILENAME_MAX];
+  unsigned isStdout = (run->dest != (const char *)0)
+                      && (strcmp( run->dest, "-" ) == 0);
+  u32 i;
+
+  memset( &pool, 0, sizeof(pool) );
+
+  while ( (i = __sync_fetch_and_add( &run->next, 1U )) < run->count )
+  {
+    u8 *dst = (u8 *)0;
+    u32 sizeDecoded = 0;
+    u32 verdict;
+
+    if (    (isStdout == 0)
+         && (_getUnpackPath( run->paths[i], run->dest, run->count,
+                             unpackPath ) != 0) )
+    {
+      fprintf( STATUS, ">>> \"%s\": Path length is too long!\n",
+                       run->paths[i] );
+      __sync_fetch_and_add( &run->failed, 1U );
+      continue;
+    }
+
+    verdict = _unpackFile( run->paths[i],
+                           ((isStdout != 0) ? (const char *)0 : unpackPath),
+                           &pool, &dst, &sizeDecoded );
+
+    if ( isStdout != 0 )
+    {
+#ifdef XSLI_THREADS
+      pthread_mutex_lock( &run->lock );
+
+      while ( run->turn != i )
+      {
+        pthread_cond_wait( &run->ready, &run->lock );
+      }
+
+      pthread_mutex_unlock( &run->lock );
+#endif
+
+      if (    (verdict == VERIFY_OK)
+           && (fwrite( dst, sizeof(u8), sizeDecoded, stdout ) != sizeDecoded) )
+      {
+        verdict = VERIFY_KINDS;
+      }
+
+#ifdef XSLI_THREADS
+      pthread_mutex_lock( &run->lock );
+      run->turn++;
+      pthread_cond_broadcast( &run->ready );
+      pthread_mutex_unlock( &run->lock );
+#endif
+    }
+
+    if ( verdict != VERIFY_OK )
+    {
+      fprintf( STATUS, ">>> \"%s\": %s\n", run->paths[i],
+                       ((verdict == VERIFY_KINDS) ?
+                        "FAILED: Unable to read or write" :
+                        verdicts[verdict]) );
+      __sync_fetch_and_add( &run->failed, 1U );
+    }
+  }
+
+  _poolFree( &pool );
+  return (void *)0;
+}
+
+
+
+static int unpackSLI( const char **paths, const u32 count, const char *dest )
+{
+  struct unpackRun run;
+
+  run.paths  = paths;
+  run.dest   = dest;
+  run.count  = count;
+  run.next   = 0;
+  run.failed = 0;
+  run.turn   = 0;
+
+#ifdef XSLI_THREADS
+  pthread_mutex_init( &run.lock, (const pthread_mutexattr_t *)0 );
+  pthread_cond_init( &run.ready, (const pthread_condattr_t *)0 );
+
+  {
+    pthread_t workers[THREADS_MAX];
+    u32 limit   = (threads < count) ? threads : count;
+    u32 started = 0;
+
+    while (    (started + 1U < limit)
+            && (pthread_create( &workers[started], (const pthread_attr_t *)0,
+                                _unpackFiles, &run ) == 0) )
+    {
+      ++started;
+    }
+
+    _unpackFiles( &run );
+
+    while ( started != 0 )
+    {
+      pthread_join( workers[--started], (void **)0 );
+    }
+  }
+
+  pthread_cond_destroy( &run.ready );
+  pthread_mutex_destroy( &run.lock );
+#else
+  _unpackFiles( &run );
+#endif
+
+  fflush( stdout );
+  fprintf( STATUS, "# Unpacked: %u\n# Failed: %u\n",
+                   count - run.failed, run.failed );
+  return (run.failed != 0) ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
+
+
+static void  _usage( void );
+static const char **_processArgs();
+static int   _parseFilter();
+static int   _compareU32();
+static int   _closeROM();
+static void  _getPath();
+static void  _orderBytes();
+static u32   _getFourCC();
+static u32   _getSwizzle();
+static int   _writeROM();
+static void  _getBSPath();
+
+/*-------------------------------------------------------
+CRC1 and CRC2 of an N64 ROM's header, as read from it and
+as summed over it for the CIC chip its boot code is for.
+-------------------------------------------------------*/
+struct boot
+{
+  u32 cic;
+  u32 header[2];
+  u32 crcs[2];
+};
+
+static void  _sumBoot();
+static void  _putBoot();
+static int   _fixBoot();
+
+
+
+/*---------------------------------------------------------------------
+"--diff" compares two ROMs by their blocks as assets, not by offset.
+Both are scanned at once, as "-u" indexes them, and the blocks are
+paired off in rounds, each costlier than the last:
+
+  1. The same raw bytes, by length and CRC32: "unchanged", or "moved"
+     where the offsets differ. Nothing is decoded for these.
+  2. The same decoded data, by size, CRC32 and FNV-1a, of the rest,
+     decoded with the checks of "--verify" across "-j" threads;
+     "recoded" where the format or raw size at the same offset differ.
+  3. The same offset and format, then the pairs most alike by the
+     sketches of "-h", down to SKETCH_NEAR: "modified".
+
+Whatever is left was "removed" from the first ROM or "added" to the
+second. Only the top level of each ROM is compared.
+---------------------------------------------------------------------*/
+#define DIFF_NONE     0xFFFFFFFFU
+#define DIFF_SAME     0
+#define DIFF_MOVED    1
+#define DIFF_MODIFIED 2
+#define DIFF_REMOVED  3
+#define DIFF_ADDED    4
+#define DIFF_RECODED  5
+
+struct asset
+{
+  u32 raw;            /* CRC32 of the raw block */
+  u32 crc;            /* Of the decoded data, */
+  u32 fnv;            /* with "isDecoded" only */
+  u32 sketch[SKETCH_BINS];
+  u32 partner;        /* Block of the other ROM, or DIFF_NONE */
+  u32 kind;
+  unsigned isDecoded;
+};
+
+struct side
+{
+  const char *path;
+  u8 *srcbuf;
+  u32 lengthROM;
+  u32 xr;
+  const struct quirk *quirk;
+  struct index index;
+  struct asset *assets;
+  u32 oddities;
+  int code;
+};
+
+/*--------------------------------------------------------
+Shared by the workers of round 2, which take the blocks of
+both ROMs in turn from "next", the first ROM's first.
+--------------------------------------------------------*/
+struct diffRun
+{
+  struct side *sides;
+  u32 next;
+  u32 decoded;
+};
+
+struct diffKey
+{
+  u32 size;
+  u32 crc;
+  u32 i;
+};
+
+struct diffPair
+{
+  double similarity;
+  u32 a;
+  u32 b;
+};
+
+
+
+/*-----------------------------------------------------------------
+Reads the ROM of "side" whole, then indexes its top-level blocks
+and takes the CRC32 of each, in Big-Endian order; "code" is set.
+-----------------------------------------------------------------*/
+static void *_scanSide( void *argument )
+{
+  struct side *side = (struct side *)argument;
+  struct tally tally;
+  struct pool pool;
+  FILE *ROM;
+  long length = 0;
+  u32 fourCC = 0;
+  u8 *regions;
+  u32 i;
+
+  side->code = EXIT_FAILURE;
+
+  if (    ((ROM = fopen( side->path, "rb" )) == (FILE *)0)
+       || (fseek( ROM, 0, SEEK_END ) != 0)
+       || ((length = ftell( ROM )) <= 0) || (length >= 0x3FFFFFFFL)
+       || (fseek( ROM, 0, SEEK_SET ) != 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to read \"%s\"!\n\n", side->path );
+    goto err;
+  }
+
+  side->lengthROM = (u32)length;
+
+  if (    ((side->srcbuf = (u8 *)malloc( side->lengthROM + 4U )) == (u8 *)0)
+       || (fread( side->srcbuf, sizeof(u8), side->lengthROM, ROM )
+           != side->lengthROM) )
+  {
+    fprintf( STATUS, "\n>>> Unable to read \"%s\"!\n\n", side->path );
+    goto err;
+  }
+
+  fclose( ROM );
+  ROM = (FILE *)0;
+  memset( &side->srcbuf[side->lengthROM], 0, 4 );
+
+  if ( side->lengthROM >= 0x40U )
+  {
+    fourCC = _getFourCC( _swap32( *(u32 *)side->srcbuf ) );
+  }
+
+  if ( fourCC != 0 )
+  {
+    side->lengthROM = (side->lengthROM + 3U) & ~3U;
+  }
+
+  side->xr    = _getSwizzle( fourCC );
+  side->quirk = _getQuirk( (fourCC != 0) ?
+                           _peek32( side->srcbuf, 0x3BU, side->xr ) : 0 );
+
+  memset( &pool, 0, sizeof(pool) );
+  memset( &tally, 0, sizeof(tally) );
+  tally.pool    = &pool;
+  tally.index   = &side->index;
+  tally.pathROM = side->path;
+  tally.fdROM   = -1;
+  regions = (u8 *)_poolGet( &pool, POOL_REGION, 0,
+                            (side->lengthROM >> REGION_SHIFT) + 1U );
+
+  if ( regions != (u8 *)0 )
+  {
+    _mapRegions( side->srcbuf, side->lengthROM, regions, 0 );
+    tally.regions = regions;
+  }
+
+  scanSLI( side->srcbuf, side->lengthROM, fourCC, side->xr, "", (u32)0,
+           &tally );
+  _poolFree( &pool );
+  side->oddities = tally.oddities;
+
+  if (    (side->index.isTruncated != 0)
+       || ((side->assets = (struct asset *)
+                           calloc( side->index.count + 1U,
+                                   sizeof(struct asset) ))
+           == (struct asset *)0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to allocate for the block index!\n\n" );
+    return (void *)0;
+  }
+
+  for ( i = 0; i < side->index.count; ++i )
+  {
+    const struct hit *hit = &side->index.hits[i];
+
+    side->assets[i].raw     = _crc32( side->srcbuf, hit->offset, hit->raw,
+                                      side->xr );
+    side->assets[i].partner = DIFF_NONE;
+  }
+
+  side->code = EXIT_SUCCESS;
+  return (void *)0;
+
+err:
+  if ( ROM != (FILE *)0 )
+  {
+    fclose( ROM );
+  }
+
+  return (void *)0;
+}
+
+
+
+static void *_decodeAssets( void *argument )
+{
+  struct diffRun *run = (struct diffRun *)argument;
+  u32 total = run->sides[0].index.count + run->sides[1].index.count;
+  struct pool pool;
+  u32 i;
+
+  memset( &pool, 0, sizeof(pool) );
+
+  while ( (i = __sync_fetch_and_add( &run->next, 1U )) < total )
+  {
+    struct side *side = &run->sides[i >= run->sides[0].index.count];
+    const struct hit *hit;
+    struct asset *asset;
+    u8 *block;
+    u8 *dst;
+
+    i    -= (side == run->sides) ? 0 : run->sides[0].index.count;
+    hit   = &side->index.hits[i];
+    asset = &side->assets[i];
+
+    if (    (asset->partner != DIFF_NONE)
+         || (hit->decoded == 0) || (hit->decoded >= 0x3FFFFFFFU)
+         || ((block = _getHitBlock( side->srcbuf, side->xr, side->quirk,
+                                    hit, &pool )) == (u8 *)0)
+         || ((dst = (u8 *)_poolGet( &pool, POOL_DECODED, 0, hit->decoded ))
+             == (u8 *)0) )
+    {
+      continue;
+    }
+
+    TRACE_BEGIN( TRACE_DECODE, hit->offset, hit->magic );
+
+    if ( _checkBlock( block, hit->raw, hit->magic, dst, hit->decoded,
+                      (struct shape *)0 ) == VERIFY_OK )
+    {
+      asset->crc = _crc32( dst, 0, hit->decoded, 0 );
+      _sketchData( dst, hit->decoded, asset->sketch, &asset->fnv );
+      asset->isDecoded = 1;
+      __sync_fetch_and_add( &run->decoded, 1U );
+      METER_ADD( decoded, hit->decoded );
+    }
+
+    TRACE_END( TRACE_DECODE, hit->offset, hit->magic );
+  }
+
+  _poolFree( &pool );
+  return (void *)0;
+}
+
+
+
+static int _compareKeys( const void *a, const void *b )
+{
+  const struct diffKey *x = (const struct diffKey *)a;
+  const struct diffKey *y = (const struct diffKey *)b;
+
+  if ( x->size != y->size )
+  {
+    return (x->size < y->size) ? -1 : 1;
+  }
+
+  if ( x->crc != y->crc )
+  {
+    return (x->crc < y->crc) ? -1 : 1;
+  }
+
+  return (x->i < y->i) ? -1 : (x->i > y->i);
+}
+
+
+
+static int _comparePairs( const void *a, const void *b )
+{
+  const struct diffPair *x = (const struct diffPair *)a;
+  const struct diffPair *y = (const struct diffPair *)b;
+
+  if ( x->similarity != y->similarity )
+  {
+    return (x->similarity < y->similarity) ? 1 : -1;
+  }
+
+  if ( x->a != y->a )
+  {
+    return (x->a < y->a) ? -1 : 1;
+  }
+
+  return (x->b < y->b) ? -1 : (x->b > y->b);
+}
+
+
+
+static void _pairAssets( struct side *sides, const u32 a, const u32 b,
+                         u32 kind )
+{
+  const struct hit *x = &sides[0].index.hits[a];
+  const struct hit *y = &sides[1].index.hits[b];
+
+  if ( (kind != DIFF_MODIFIED) && (x->offset != y->offset) )
+  {
+    kind = DIFF_MOVED;
+  }
+  else if (    (kind != DIFF_MODIFIED)
+            && ((x->magic != y->magic) || (x->raw != y->raw)) )
+  {
+    kind = DIFF_RECODED;
+  }
+
+  sides[0].assets[a].partner = b;
+  sides[0].assets[a].kind    = kind;
+  sides[1].assets[b].partner = a;
+  sides[1].assets[b].kind    = kind;
+  return;
+}
+
+
+
+/*-----------------------------------------------------------------
+Rounds 1 and 2: pairs the blocks left with ones of the same raw or
+decoded data in the other ROM, by sorted keys, those at the same
+offset first. Returns non-zero where there was no memory for keys.
+-----------------------------------------------------------------*/
+static int _pairExact( struct side *sides, const unsigned isDecoded )
+{
+  struct side *b = &sides[1];
+  struct diffKey *keys;
+  struct diffKey key;
+  u32 count = 0;
+  u32 i;
+
+  if ( (keys = (struct diffKey *)malloc( sizeof(struct diffKey) *
+                                         (b->index.count + 1U) ))
+       == (struct diffKey *)0 )
+  {
+    return 1;
+  }
+
+  for ( i = 0; i < b->index.count; ++i )
+  {
+    const struct asset *asset = &b->assets[i];
+
+    if (    (asset->partner == DIFF_NONE)
+         && ((isDecoded == 0) || (asset->isDecoded != 0)) )
+    {
+      keys[count].size = (isDecoded != 0) ? b->index.hits[i].decoded :
+                                            b->index.hits[i].raw;
+      keys[count].crc  = (isDecoded != 0) ? asset->crc : asset->raw;
+      keys[count].i    = i;
+      ++count;
+    }
+  }
+
+  qsort( keys, count, sizeof(struct diffKey), _compareKeys );
+
+  for ( i = 0; i < sides[0].index.count; ++i )
+  {
+    const struct asset *asset = &sides[0].assets[i];
+    const struct hit *hit     = &sides[0].index.hits[i];
+    u32 best = DIFF_NONE;
+    u32 low  = 0;
+    u32 high = count;
+
+    if (    (asset->partner != DIFF_NONE)
+         || ((isDecoded != 0) && (asset->isDecoded == 0)) )
+    {
+      continue;
+    }
+
+    key.size = (isDecoded != 0) ? hit->decoded : hit->raw;
+    key.crc  = (isDecoded != 0) ? asset->crc : asset->raw;
+    key.i    = 0;
+
+    while ( low < high )
+    {
+      u32 middle = low + ((high - low) >> 1);
+
+      if ( _compareKeys( &keys[middle], &key ) < 0 )
+      {
+        low = middle + 1U;
+      }
+      else
+      {
+        high = middle;
+      }
+    }
+
+    while (    (low < count)
+            && (keys[low].size == key.size) && (keys[low].crc == key.crc) )
+    {
+      u32 j = keys[low++].i;
+
+      if (    (b->assets[j].partner != DIFF_NONE)
+           || ((isDecoded != 0) && (b->assets[j].fnv != asset->fnv)) )
+      {
+        continue;
+      }
+
+      if ( best == DIFF_NONE )
+      {
+        best = j;
+      }
+
+      if ( b->index.hits[j].offset == hit->offset )
+      {
+        best = j;
+        break;
+      }
+    }
+
+    if ( best != DIFF_NONE )
+    {
+      _pairAssets( sides, i, best, DIFF_SAME );
+    }
+  }
+
+  free( keys );
+  return 0;
+}
+
+
+
+/*-----------------------------------------------------------------
+Round 3: blocks left at the same offset in the same format, then
+the most alike of the rest, greedily. Returns non-zero as above.
+-----------------------------------------------------------------*/
+static int _pairNear( struct side *sides )
+{
+  struct side *b = &sides[1];
+  struct diffPair *pairs = (struct diffPair *)0;
+  u32 count = 0;
+  u32 capacity = 0;
+  u32 i;
+  u32 j = 0;
+
+  for ( i = 0; i < sides[0].index.count; ++i )
+  {
+    const struct hit *hit = &sides[0].index.hits[i];
+
+    if ( sides[0].assets[i].partner != DIFF_NONE )
+    {
+      continue;
+    }
+
+    while ( (j < b->index.count) && (b->index.hits[j].offset < hit->offset) )
+    {
+      ++j;
+    }
+
+    if (    (j < b->index.count) && (b->index.hits[j].offset == hit->offset)
+         && (b->index.hits[j].magic == hit->magic)
+         && (b->assets[j].partner == DIFF_NONE) )
+    {
+      _pairAssets( sides, i, j, DIFF_MODIFIED );
+    }
+  }
+
+  for ( i = 0; i < sides[0].index.count; ++i )
+  {
+    if (    (sides[0].assets[i].partner != DIFF_NONE)
+         || (sides[0].assets[i].isDecoded == 0) )
+    {
+      continue;
+    }
+
+    for ( j = 0; j < b->index.count; ++j )
+    {
+      double similarity;
+
+      if (    (b->assets[j].partner != DIFF_NONE)
+           || (b->assets[j].isDecoded == 0) )
+      {
+        continue;
+      }
+
+      similarity = _getSimilarity( sides[0].assets[i].sketch,
+                                   b->assets[j].sketch );
+
+      if ( similarity < SKETCH_NEAR )
+      {
+        continue;
+      }
+
+      if ( count == capacity )
+      {
+        u32 most = (capacity != 0) ? (capacity << 1) : 64U;
+        struct diffPair *more = (struct diffPair *)
+                                realloc( pairs,
+                                         most * sizeof(struct diffPair) );
+
+        if ( more == (struct diffPair *)0 )
+        {
+          free( pairs );
+          return 1;
+        }
+
+        pairs    = more;
+        capacity = most;
+      }
+
+      pairs[count].similarity = similarity;
+      pairs[count].a          = i;
+      pairs[count].b          = j;
+      ++count;
+    }
+  }
+
+  if ( count > 1 )
+  {
+    qsort( pairs, count, sizeof(struct diffPair), _comparePairs );
+  }
+
+  for ( i = 0; i < count; ++i )
+  {
+    if (    (sides[0].assets[pairs[i].a].partner == DIFF_NONE)
+         && (b->assets[pairs[i].b].partner == DIFF_NONE) )
+    {
+      _pairAssets( sides, pairs[i].a, pairs[i].b, DIFF_MODIFIED );
+    }
+  }
+
+  free( pairs );
+  return 0;
+}
+
+
+
+static void _putChange( const char *kind, const struct hit *a,
+                        const struct hit *b )
+{
+  char nameA[16] = "-";
+  char nameB[16] = "-";
+  const struct hit *hit = (b != (const struct hit *)0) ? b : a;
+  long decoded = (long)hit->decoded;
+  long raw     = (long)hit->raw;
+
+  if ( a != (const struct hit *)0 )
+  {
+    sprintf( nameA, "0x%X", a->offset );
+    decoded = (b != (const struct hit *)0) ?
+              (long)b->decoded - (long)a->decoded : -decoded;
+    raw     = (b != (const struct hit *)0) ?
+              (long)b->raw - (long)a->raw : -raw;
+  }
+
+  if ( b != (const struct hit *)0 )
+  {
+    sprintf( nameB, "0x%X", b->offset );
+  }
+
+  printf( "%-8s %-12s %-12s %s %10u %+11ld %+11ld\n",
+          kind, nameA, nameB, _getFormatName( hit->magic ),
+          hit->decoded, decoded, raw );
+  return;
+}
+
+
+
+static int diffSLI( const char *pathA, const char *pathB )
+{
+  struct side sides[2];
+  struct diffRun run;
+  u32 kinds[DIFF_RECODED + 1];
+  int code = EXIT_FAILURE;
+  u32 i;
+
+  memset( sides, 0, sizeof(sides) );
+  memset( kinds, 0, sizeof(kinds) );
+  sides[0].path = pathA;
+  sides[1].path = pathB;
+
+#ifdef XSLI_THREADS
+  {
+    pthread_t worker;
+
+    if ( pthread_create( &worker, (const pthread_attr_t *)0,
+                         _scanSide, &sides[1] ) == 0 )
+    {
+      _scanSide( &sides[0] );
+      pthread_join( worker, (void **)0 );
+    }
+    else
+    {
+      _scanSide( &sides[0] );
+      _scanSide( &sides[1] );
+    }
+  }
+#else
+  _scanSide( &sides[0] );
+  _scanSide( &sides[1] );
+#endif
+
+  if ( (sides[0].code != EXIT_SUCCESS) || (sides[1].code != EXIT_SUCCESS) )
+  {
+    goto err;
+  }
+
+  if ( _pairExact( sides, 0 ) != 0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to allocate for the comparison!\n\n" );
+    goto err;
+  }
+
+  run.sides   = sides;
+  run.next    = 0;
+  run.decoded = 0;
+
+#ifdef XSLI_THREADS
+  {
+    pthread_t workers[THREADS_MAX];
+    u32 total   = sides[0].index.count + sides[1].index.count;
+    u32 count   = ((threads - 1U) < total) ? (threads - 1U) : total;
+    u32 started = 0;
+
+    while (    (started < count)
+            && (pthread_create( &workers[started], (const pthread_attr_t *)0,
+                                _decodeAssets, &run ) == 0) )
+    {
+      ++started;
+    }
+
+    _decodeAssets( &run );
+
+    while ( started != 0 )
+    {
+      pthread_join( workers[--started], (void **)0 );
+    }
+  }
+#else
+  _decodeAssets( &run );
+#endif
+
+  if ( (_pairExact( sides, 1 ) != 0) || (_pairNear( sides ) != 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to allocate for the comparison!\n\n" );
+    goto err;
+  }
+
+  /*----------------------------------------------------------
+  Changes are listed in the order of the first ROM, and those
+  only in the second after them, in its order.
+  ----------------------------------------------------------*/
+  for ( i = 0; i < sides[0].index.count; ++i )
+  {
+    const struct asset *asset = &sides[0].assets[i];
+    const struct hit *hit     = &sides[0].index.hits[i];
+
+    if ( asset->partner == DIFF_NONE )
+    {
+      _putChange( "REMOVED", hit, (const struct hit *)0 );
+      kinds[DIFF_REMOVED]++;
+      continue;
+    }
+
+    kinds[asset->kind]++;
+
+    if ( asset->kind != DIFF_SAME )
+    {
+      _putChange( (asset->kind == DIFF_MOVED)   ? "MOVED"
+                  : (asset->kind == DIFF_RECODED) ? "RECODED" : "MODIFIED",
+                  hit, &sides[1].index.hits[asset->partner] );
+    }
+  }
+
+  for ( i = 0; i < sides[1].index.count; ++i )
+  {
+    if ( sides[1].assets[i].partner == DIFF_NONE )
+    {
+      _putChange( "ADDED", (const struct hit *)0, &sides[1].index.hits[i] );
+      kinds[DIFF_ADDED]++;
+    }
+  }
+
+  fflush( stdout );
+  fprintf( STATUS, "# Unchanged: %u\n# Moved: %u\n# Recoded: %u\n"
+                   "# Modified: %u\n# Removed: %u\n# Added: %u\n",
+                   kinds[DIFF_SAME], kinds[DIFF_MOVED], kinds[DIFF_RECODED],
+                   kinds[DIFF_MODIFIED], kinds[DIFF_REMOVED],
+                   kinds[DIFF_ADDED] );
+
+  if ( options.verbose != 0 )
+  {
+    fprintf( STATUS, "# Decoded: %u of %u blocks\n"
+                     "# Oddities: %u, %u\n",
+                     run.decoded,
+                     sides[0].index.count + sides[1].index.count,
+                     sides[0].oddities, sides[1].oddities );
+  }
+
+  code = EXIT_SUCCESS;
+
+err:
+  for ( i = 0; i < 2; ++i )
+  {
+    free( sides[i].srcbuf );
+    free( sides[i].index.hits );
+    free( sides[i].assets );
+  }
+
+  return code;
+}
+
+
+
+#ifdef XSLI_THREADS
+/*---------------------------------------------------------------------
+With "-o", a writer thread puts the ROM into Big-Endian order and
+writes it out a chunk at a time, as each chunk is read in, rather than
+after the whole ROM has been ordered. The scan doesn't wait for it at
+all: it reads the ROM in its own byte order, as it would without "-o",
+so ordering and writing overlap with reading, then with scanning, and
+only the ROM buffer is shared, read-only past what "loaded" says.
+---------------------------------------------------------------------*/
+#define PIPE_CHUNK 0x100000U
+
+static struct
+{
+  pthread_t writer;
+  pthread_mutex_t lock;
+  pthread_cond_t ready;
+  const u8 *srcbuf;
+  u8 *chunk;
+  FILE *BS;
+  char path[PPATH_MAX + 8];
+  u32 fourCC;
+  /*--------------------------------------------------------------
+  Guarded by "lock": bytes read so far, and once "isFinal" is set,
+  all there will be [32-bit aligned]; "isAborted" drops the file.
+  --------------------------------------------------------------*/
+  u32 loaded;
+  unsigned isFinal;
+  unsigned isAborted;
+  unsigned isFailed;
+  unsigned isRunning;
+}
+pipeline;
+
+
+
+static void *_pipeWrite( void *argument )
+{
+  u32 done = 0;
+
+  (void)argument;
+
+  for ( ;; )
+  {
+    u32 upto;
+
+    pthread_mutex_lock( &pipeline.lock );
+
+    while (    (pipeline.isAborted == 0) && (pipeline.isFinal == 0)
+            && ((pipeline.loaded & ~3U) == done) )
+    {
+      pthread_cond_wait( &pipeline.ready, &pipeline.lock );
+    }
+
+    upto = (pipeline.isAborted != 0) ? done : (pipeline.loaded & ~3U);
+    pthread_mutex_unlock( &pipeline.lock );
+
+    while ( (done < upto) && (pipeline.isFailed == 0) )
+    {
+      u32 length = ((upto - done) < PIPE_CHUNK) ? (upto - done) : PIPE_CHUNK;
+
+      memcpy( pipeline.chunk, &pipeline.srcbuf[done], length );
+      TRACE_BEGIN( TRACE_ORDER, done, 0 );
+      _orderBytes( pipeline.chunk, pipeline.fourCC, length );
+      TRACE_END( TRACE_ORDER, done, 0 );
+
+      if ( fwrite( pipeline.chunk, sizeof(u8), length, pipeline.BS )
+           != length )
+      {
+        pipeline.isFailed = 1;
+      }
+
+      METER_ADD( written, length );
+      done += length;
+    }
+
+    pthread_mutex_lock( &pipeline.lock );
+
+    if (    (pipeline.isAborted != 0) || (pipeline.isFailed != 0)
+         || ((pipeline.isFinal != 0) && (done == pipeline.loaded)) )
+    {
+      pthread_mutex_unlock( &pipeline.lock );
+      break;
+    }
+
+    pthread_mutex_unlock( &pipeline.lock );
+  }
+
+  return (void *)0;
+}
+
+
+
+/*-----------------------------------------------------------------
+Starts the writer for a ROM whose first bytes have been read, when
+it is to be written in Big-Endian order; otherwise, or should the
+writer not start, "_writeROM" is left to do it all afterwards.
+-----------------------------------------------------------------*/
+static void _startPipe( const u8 *srcbuf, const char *pathROM )
+{
+  u32 fourCC = _getFourCC( _swap32( *(u32 *)srcbuf ) );
+
+  pipeline.isRunning = 0;
+
+  if ( (options.writeROM == 0) || (fourCC == 0) || ((fourCC & 8U) != 0) )
+  {
+    return;
+  }
+
+  _getBSPath( pathROM, pipeline.path );
+
+  if ( (pipeline.chunk = (u8 *)malloc( PIPE_CHUNK )) == (u8 *)0 )
+  {
+    return;
+  }
+
+  if ( (pipeline.BS = fopen( pipeline.path, "wb" )) == (FILE *)0 )
+  {
+    free( pipeline.chunk );
+    return;
+  }
+
+  pipeline.srcbuf    = srcbuf;
+  pipeline.fourCC    = fourCC;
+  pipeline.loaded    = 0;
+  pipeline.isFinal   = 0;
+  pipeline.isAborted = 0;
+  pipeline.isFailed  = 0;
+  pthread_mutex_init( &pipeline.lock, (const pthread_mutexattr_t *)0 );
+  pthread_cond_init( &pipeline.ready, (const pthread_condattr_t *)0 );
+
+  if ( pthread_create( &pipeline.writer, (const pthread_attr_t *)0,
+                       _pipeWrite, (void *)0 ) != 0 )
+  {
+    pthread_cond_destroy( &pipeline.ready );
+    pthread_mutex_destroy( &pipeline.lock );
+    fclose( pipeline.BS );
+    remove( pipeline.path );
+    free( pipeline.chunk );
+    return;
+  }
+
+  pipeline.isRunning = 1;
+  return;
+}
+
+
+
+static void _feedPipe( const u32 loaded, const unsigned isFinal )
+{
+  pthread_mutex_lock( &pipeline.lock );
+  pipeline.loaded  = loaded;
+  pipeline.isFinal = isFinal;
+  pthread_cond_signal( &pipeline.ready );
+  pthread_mutex_unlock( &pipeline.lock );
+  return;
+}
+
+
+
+/*---------------------------------------------------------------
+Waits for the writer, and removes what it wrote if the ROM wasn't
+read in full or couldn't be written; returns "EXIT_FAILURE" then.
+---------------------------------------------------------------*/
+static int _finishPipe( const unsigned isAborted )
+{
+  int code;
+
+  pthread_mutex_lock( &pipeline.lock );
+  pipeline.isAborted = isAborted;
+  pthread_cond_signal( &pipeline.ready );
+  pthread_mutex_unlock( &pipeline.lock );
+  pthread_join( pipeline.writer, (void **)0 );
+  pthread_cond_destroy( &pipeline.ready );
+  pthread_mutex_destroy( &pipeline.lock );
+
+  code = (    (fclose( pipeline.BS ) != 0) || (pipeline.isFailed != 0)
+          || (isAborted != 0) ) ? EXIT_FAILURE : EXIT_SUCCESS;
+
+  if ( code != EXIT_SUCCESS )
+  {
+    remove( pipeline.path );
+
+    if ( isAborted == 0 )
+    {
+      fprintf( STATUS, "\n>>> Unable to write the Big-Endian ROM!\n\n" );
+    }
+  }
+
+  free( pipeline.chunk );
+  pipeline.isRunning = 0;
+  return code;
+}
+
+
+
+static u32 _readROM( FILE *ROM, u8 *srcbuf, const u32 lengthROM,
+                     const char *pathROM )
+{
+  u32 lengthRead = 0;
+
+  /*---------------------------------------------------------
+  There is but the one writer, so ROMs taken by "--watch"
+  workers at once are put in order and written afterwards.
+  ---------------------------------------------------------*/
+  if ( options.watch != 0 )
+  {
+    return (u32)fread( srcbuf, sizeof(u8), lengthROM, ROM );
+  }
+
+  pipeline.isRunning = 0;
+
+  while ( lengthRead < lengthROM )
+  {
+    u32 length = ((lengthROM - lengthRead) < PIPE_CHUNK) ?
+                 (lengthROM - lengthRead) : PIPE_CHUNK;
+
+    if ( fread( &srcbuf[lengthRead], sizeof(u8), length, ROM ) != length )
+    {
+      break;
+    }
+
+    if ( (lengthRead == 0) && (length >= 0x40U) )
+    {
+      _startPipe( srcbuf, pathROM );
+    }
+
+    lengthRead += length;
+
+    if ( pipeline.isRunning != 0 )
+    {
+      _feedPipe( lengthRead, 0 );
+    }
+  }
+
+  if ( (lengthRead != lengthROM) && (pipeline.isRunning != 0) )
+  {
+    _finishPipe( 1 );
+  }
+
+  return lengthRead;
+}
+#endif
+
+
+
+static int processROM( const char *path, struct pool *pool )
+{
+  char  pathROM[PPATH_MAX];
+  char  cdirROM[PPATH_MAX];
+  FILE *ROM  = (FILE *)0;
+
+  strcpy( pathROM, path );
+  strcpy( cdirROM, path );
+
+  if ( (ROM = fopen( pathROM, "rb" )) == (FILE *)0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to open:\n>>> \"%s\"\n\n", pathROM );
+    return EXIT_FAILURE;
+  }
+  else
+  {
+    u8 *srcbuf = (u8 *)0;
+    u32 lengthROM;
+
+    fseek( ROM, 0L, SEEK_END );
+    lengthROM = (u32)ftell( ROM );
+
+    if (    (lengthROM == (u32)EOF)
+         || (lengthROM >= 0x3FFFFFFF)
+         || (lengthROM == 0) )
+    {
+      fprintf( STATUS, "\n>>> Unsupported ROM file size!\n\n" );
+      return _closeROM( ROM, 1 );
+    }
+    else
+    {
+      srcbuf = (u8 *)_poolGet( pool, POOL_ROM, 0, (lengthROM + 3U) & ~3U );
+
+      if ( srcbuf == (u8 *)0 )
+      {
+        fprintf( STATUS, "\n>>> Error allocating RAM for ROM buffer!\n\n" );
+        return _closeROM( ROM, 1 );
+      }
+      else
+      {
+        u32 lengthRead;
+        unsigned isPiped = 0;
+
+        rewind( ROM );
+        TRACE_BEGIN( TRACE_LOAD, 0, 0 );
+#ifdef XSLI_THREADS
+        lengthRead = _readROM( ROM, srcbuf, lengthROM, pathROM );
+        isPiped    = (lengthRead == lengthROM) && (pipeline.isRunning != 0);
+#else
+        lengthRead = (u32)fread( srcbuf, sizeof(u8), lengthROM, ROM );
+#endif
+        TRACE_END( TRACE_LOAD, 0, 0 );
+
+        if ( lengthRead != lengthROM )
+        {
+          fprintf( STATUS,
+                   "\n>>> Error reading from ROM file into buffer!\n\n" );
+          return _closeROM( ROM, 1 );
+        }
+        else
+        {
+          u32 magic  = _swap32( *(u32 *)srcbuf );
+          u32 fourCC = 0;
+          u32 xr     = 0;
+          int code   = EXIT_SUCCESS;
+          int isIndexed = 0;
+          struct tally tally;
+          struct boot  boot;
+
+          tally.pool     = pool;
+          tally.index    = (struct index *)0;
+          tally.pathROM  = path;
+          tally.hits     = 0;
+          tally.oddities = 0;
+          tally.nested   = 0;
+          tally.filtered = 0;
+          tally.carved   = 0;
+          tally.zeroCopies = 0;
+          tally.regions  = (const u8 *)0;
+          tally.skipped  = 0;
+          tally.shape    = (analytics.JSON != (FILE *)0) ?
+                           &analytics.block : (struct shape *)0;
+#ifdef XSLI_ZEROCOPY
+          tally.fdROM    = fileno( ROM );
+#else
+          tally.fdROM    = -1;
+#endif
+
+          _getPath( cdirROM );
+          fourCC = _getFourCC( magic );
+          memset( &boot, 0, sizeof(boot) );
+
+#ifdef XSLI_WATCH
+          /*---------------------------------------------------------
+          The ROMs of a watched directory are processed at once, so
+          their blocks are named after them, "game.z64_0x1400.szs",
+          rather than overwriting one another's as they're written.
+          ---------------------------------------------------------*/
+          if ( options.watch != 0 )
+          {
+            sprintf( cdirROM, "%s_", path );
+          }
+#endif
+
+          if ( fourCC == 0 )
+          {
+            fprintf( STATUS,
+                     "# Not an N64 ROM!\n"
+                     "# Will attempt to scan for Big-Endian SLI data.\n" );
+
+            if ( options.useGameName != 0 )
+            {
+              fprintf( STATUS, "<USE-GAME-NAME:  DISABLED>\n" );
+            }
+
+            if ( options.writeROM != 0 )
+            {
+              fprintf( STATUS, "<WRITE-BE-ROM:   DISABLED>\n" );
+            }
+          }
+          else
+          {
+            if ( (fourCC & 8U) == 0 )
+            {
+              /*-----------------------------------------------------
+              The ROM buffer was allocated with room for this already.
+              -----------------------------------------------------*/
+              if ( (lengthROM & 3) != 0 )
+              {
+                u32 lengthRead = lengthROM;
+
+                fprintf( STATUS, "# ROM isn't 32-bit aligned...\n"
+                                 "# Aligning.\n" );
+
+                while ( (lengthROM & 3) != 0 )
+                {
+                  ++lengthROM;
+                }
+
+                memset( &srcbuf[lengthRead], 0, lengthROM - lengthRead );
+              }
+
+              /*---------------------------------------------------------
+              The whole ROM is only put into Big-Endian order when it is
+              to be written out; otherwise, the scan reads it in place.
+              ---------------------------------------------------------*/
+              if ( isPiped != 0 )
+              {
+                fprintf( STATUS, "# Found Nintendo 64 ROM Magic!\n"
+                                 "# Ordering bytes to Big-Endian "
+                                 "while scanning.\n" );
+#ifdef XSLI_THREADS
+                _feedPipe( lengthROM, 1 );
+#endif
+                xr = _getSwizzle( fourCC );
+              }
+              else if ( options.writeROM != 0 )
+              {
+                fprintf( STATUS, "# Found Nintendo 64 ROM Magic!\n"
+                                 "# Ordering bytes to Big-Endian.\n" );
+                TRACE_BEGIN( TRACE_ORDER, 0, 0 );
+                _orderBytes( srcbuf, fourCC, lengthROM );
+                TRACE_END( TRACE_ORDER, 0, 0 );
+                tally.fdROM = -1;
+
+                if ( _writeROM( srcbuf, lengthROM, pathROM ) != 0 )
+                {
+                  fclose( ROM );
+                  return EXIT_FAILURE;
+                }
+              }
+              else
+              {
+                fprintf( STATUS, "# Found Nintendo 64 ROM Magic!\n"
+                                 "# Scanning in native byte order.\n" );
+                xr = _getSwizzle( fourCC );
+              }
+            }
+
+            /*-----------------------------------------------------
+            Summed as the scan reads the ROM; Big-Endian if it was
+            just put into that order, with nothing left to swizzle.
+            -----------------------------------------------------*/
+            _sumBoot( srcbuf, lengthROM, (xr == 0) ? 8U : fourCC, &boot );
+          }
+
+          /*------------------------------------------------------
+          Without room for a map, the scan simply crawls the ROM.
+          ------------------------------------------------------*/
+          {
+            u8 *regions = (u8 *)_poolGet( pool, POOL_REGION, 0,
+                                          (lengthROM >> REGION_SHIFT) + 1U );
+
+            if ( regions != (u8 *)0 )
+            {
+              _mapRegions( srcbuf, lengthROM, regions,
+                           options.showRegions );
+              tally.regions = regions;
+
+              if ( options.showRegions != 0 )
+              {
+                _putRegions( srcbuf, lengthROM, regions );
+              }
+            }
+          }
+
+          if ( options.emitMode != 0 )
+          {
+            u32 header[6];
+
+            header[0] = FRAME_ROM;
+            header[1] = 0;
+            header[2] = 0;
+            header[3] = EMIT_RAW;
+            header[4] = (u32)strlen( path );
+            header[5] = lengthROM;
+
+            if ( _putFrame( header, (const u8 *)path, header[4],
+                            (const u8 *)0, 0 ) != 0 )
+            {
+              fprintf( STATUS,
+                       "\n>>> Unable to write to the standard output!\n\n" );
+              fclose( ROM );
+#ifdef XSLI_THREADS
+              if ( isPiped != 0 )
+              {
+                _finishPipe( 0 );
+              }
+#endif
+              return EXIT_FAILURE;
+            }
+          }
+
+          if ( tally.shape != (struct shape *)0 )
+          {
+            _beginShapes( path );
+          }
+
+          if ( similarity.INDEX != (FILE *)0 )
+          {
+            isIndexed = _beginIndex( path, srcbuf, lengthROM, xr,
+                                     (((options.listMode != 0) ||
+                                       (options.emitMode != 0)) ?
+                                      0 : strlen( cdirROM )) );
+          }
+
+          if ( options.verify != 0 )
+          {
+            code = verifySLI( srcbuf, lengthROM, fourCC, xr, &tally );
+          }
+          else if ( isIndexed == 0 )
+          {
+            scanSLI( srcbuf, lengthROM, fourCC, xr,
+                     (((options.listMode != 0) || (options.emitMode != 0)) ?
+                      "" : cdirROM), (u32)0, &tally );
+          }
+
+          fclose( ROM );
+
+#ifdef XSLI_THREADS
+          if ( (isPiped != 0) && (_finishPipe( 0 ) != EXIT_SUCCESS) )
+          {
+            code = EXIT_FAILURE;
+          }
+#endif
+
+          if ( tally.shape != (struct shape *)0 )
+          {
+            _endShapes();
+          }
+
+          _endIndex();
+
+          if (    (code == EXIT_SUCCESS) && (options.writeROM != 0)
+               && ((fourCC & 8U) == 0)
+               && (_fixBoot( pathROM, &boot ) != EXIT_SUCCESS) )
+          {
+            code = EXIT_FAILURE;
+          }
+
+          if ( options.verify != 0 )
+          {
+            return code;
+          }
+
+          fprintf( STATUS, "# Hits: %u\n# Oddities: %u\n",
+                           tally.hits, tally.oddities );
+
+          if ( fourCC != 0 )
+          {
+            _putBoot( &boot );
+          }
+
+          if ( (options.verbose != 0) && (tally.zeroCopies != 0) )
+          {
+            fprintf( STATUS, "# Copied in-kernel: %u\n", tally.zeroCopies );
+          }
+
+          if ( (options.verbose != 0) && (tally.skipped != 0) )
+          {
+            fprintf( STATUS, "# Padding skipped: %u KiB\n",
+                             tally.skipped >> 10 );
+          }
+
+          if ( options.maxDepth != 0 )
+          {
+            fprintf( STATUS, "# Nested: %u\n", tally.nested );
+          }
+
+          if ( filter.isActive != 0 )
+          {
+            fprintf( STATUS, "# Filtered: %u\n", tally.filtered );
+          }
+
+          if ( options.carve != 0 )
+          {
+            fprintf( STATUS, "# Carved: %u\n", tally.carved );
+          }
+
+          return code;
+        }
+      }
+    }
+  }
+}
+
+
+
+#ifdef XSLI_DAEMON
+/*--------------------------------------------------------------------
+"-u" keeps serving requests over a Unix domain socket. The ROMs most
+recently asked for stay mapped alongside an index of their blocks, so
+a repeated lookup costs neither a read nor a scan. ROMs are indexed
+in their own byte order, and filters apply as they do to a scan.
+Every field is a Big-Endian u32:
+
+  Request  : OP, OFFSET, START, LENGTH, PATH LENGTH, PATH
+  Response : STATUS, PAYLOAD LENGTH, PAYLOAD
+
+  OP 1 [List]    : OFFSET, FORMAT, RAW, DECODED for each block at the
+                   top level of the ROM at PATH; FORMAT is its FourCC.
+  OP 2 [Extract] : The Big-Endian bytes of the block at OFFSET.
+  OP 3 [Decode]  : LENGTH bytes from START of the decoded block at
+                   OFFSET; a LENGTH of 0 runs to the end of the data.
+
+STATUS is one of "SRV_*" below, with no payload following an error.
+--------------------------------------------------------------------*/
+#define SRV_LIST    1U
+#define SRV_EXTRACT 2U
+#define SRV_DECODE  3U
+
+#define SRV_OK       0U
+#define SRV_BAD      1U  /* Malformed request */
+#define SRV_NOROM    2U  /* ROM unreadable */
+#define SRV_NOBLOCK  3U  /* No block indexed at OFFSET */
+#define SRV_NODECODE 4U  /* Block doesn't decode */
+#define SRV_NOMEMORY 5U
+
+#define SRV_QUEUE    64  /* Connections waiting for a worker */
+#define SRV_CACHEDEF 256 /* MiB */
+
+struct entry
+{
+  struct entry *next;
+  const struct quirk *quirk;
+  struct index index;
+  char path[PPATH_MAX];
+  dev_t device;
+  ino_t inode;
+  struct timespec modified;
+  u8 *map;
+  u32 lengthROM;
+  u32 xr;
+  /*-------------------------------------------------------------
+  "bytes" is what the entry counts against the cache limit, and
+  "lastUse" orders entries for eviction. A stale entry has been
+  unlinked for a newer copy of its ROM, but is still being used.
+  -------------------------------------------------------------*/
+  u32 bytes;
+  u32 users;
+  u32 lastUse;
+  unsigned isStale;
+};
+
+static struct
+{
+  const char *path;
+  u32 cacheLimit;
+  /*-----------------------------------------------------------
+  Everything from here on is guarded by "lock", except for
+  "isServing", stored atomically around the lifetime of "lock"
+  for the "-x" sampler, and "isSignalled", which is only set by
+  the signal handler and only read by the accepting thread.
+  -----------------------------------------------------------*/
+  pthread_mutex_t lock;
+  pthread_cond_t  waiting;
+  struct entry *entries;
+  size_t bytes;
+  u32 clock;
+  int queue[SRV_QUEUE];
+  u32 queueHead;
+  u32 queueCount;
+  int active[THREADS_MAX];
+  u32 requests;
+  u32 cacheHits;
+  u32 cacheMisses;
+  unsigned isServing;
+  unsigned isStopping;
+  volatile sig_atomic_t isSignalled;
+} server;
+
+
+
+static void _dropROM( struct entry *entry )
+{
+  munmap( (void *)entry->map, entry->lengthROM );
+  free( entry->index.hits );
+  free( entry );
+  return;
+}
+
+
+
+/*-------------------------------------------------------------------
+Unmaps the least recently used ROMs that aren't in use, until the
+cache is back within its limit. "server.lock" must be held.
+-------------------------------------------------------------------*/
+static void _trimCache( void )
+{
+  while ( server.bytes > server.cacheLimit )
+  {
+    struct entry **link   = &server.entries;
+    struct entry **oldest = (struct entry **)0;
+    struct entry *entry;
+
+    while ( *link != (struct entry *)0 )
+    {
+      if (    ((*link)->users == 0)
+           && (    (oldest == (struct entry **)0)
+                || ((*link)->lastUse < (*oldest)->lastUse)) )
+      {
+        oldest = link;
+      }
+
+      link = &(*link)->next;
+    }
+
+    if ( oldest == (struct entry **)0 )
+    {
+      break;
+    }
+
+    entry   = *oldest;
+    *oldest = entry->next;
+    server.bytes -= entry->bytes;
+    _dropROM( entry );
+  }
+
+  return;
+}
+
+
+
+/*-------------------------------------------------------------------
+Returns the cached entry for "path" as a new user of it, provided
+the file hasn't changed since; an outdated entry is unlinked instead.
+"server.lock" must be held.
+-------------------------------------------------------------------*/
+static struct entry *_findROM( const char *path, const struct stat *status )
+{
+  struct entry **link = &server.entries;
+
+  while ( *link != (struct entry *)0 )
+  {
+    struct entry *entry = *link;
+
+    if ( strcmp( entry->path, path ) == 0 )
+    {
+      if (    (entry->device == status->st_dev)
+           && (entry->inode  == status->st_ino)
+           && (entry->modified.tv_sec  == status->st_mtim.tv_sec)
+           && (entry->modified.tv_nsec == status->st_mtim.tv_nsec)
+           && ((off_t)entry->lengthROM == status->st_size) )
+      {
+        entry->users++;
+        entry->lastUse = ++server.clock;
+        return entry;
+      }
+
+      *link = entry->next;
+      server.bytes -= entry->bytes;
+
+      if ( entry->users == 0 )
+      {
+        _dropROM( entry );
+      }
+      else
+      {
+        entry->isStale = 1;
+      }
+
+      break;
+    }
+
+    link = &entry->next;
+  }
+
+  return (struct entry *)0;
+}
+
+
+
+/*-------------------------------------------------------------------
+Maps the ROM at "path" and indexes its blocks, without the lock, as
+"scanSLI" would list them. Nothing in the mapping is ever written.
+-------------------------------------------------------------------*/
+static struct entry *_loadROM( const char *path, const struct stat *status,
+                               struct pool *pool )
+{
+  struct entry *entry;
+  struct tally  tally;
+  void *map;
+  u8   *regions;
+  u32   fourCC = 0;
+  int   fd;
+
+  if ( (status->st_size <= 0) || (status->st_size >= 0x3FFFFFFF) )
+  {
+    return (struct entry *)0;
+  }
+
+  if ( (entry = (struct entry *)calloc( 1, sizeof(struct entry) ))
+       == (struct entry *)0 )
+  {
+    return (struct entry *)0;
+  }
+
+  if ( (fd = open( path, O_RDONLY )) < 0 )
+  {
+    free( entry );
+    return (struct entry *)0;
+  }
+
+  entry->lengthROM = (u32)status->st_size;
+  map = mmap( (void *)0, entry->lengthROM, PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+
+  if ( map == MAP_FAILED )
+  {
+    free( entry );
+    return (struct entry *)0;
+  }
+
+  strcpy( entry->path, path );
+  entry->map      = (u8 *)map;
+  entry->device   = status->st_dev;
+  entry->inode    = status->st_ino;
+  entry->modified = status->st_mtim;
+
+  /*--------------------------------------------------------------
+  Reads past the end of a ROM that isn't 32-bit aligned stay on
+  its last page, which the mapping fills out with zeroes.
+  --------------------------------------------------------------*/
+  if ( entry->lengthROM >= 0x40U )
+  {
+    fourCC = _getFourCC( _peek32( entry->map, 0, 0 ) );
+  }
+
+  entry->xr    = _getSwizzle( fourCC );
+  entry->quirk = _getQuirk( (fourCC != 0) ?
+                            _peek32( entry->map, 0x3BU, entry->xr ) : 0 );
+
+  memset( &tally, 0, sizeof(tally) );
+  tally.pool    = pool;
+  tally.index   = &entry->index;
+  tally.pathROM = entry->path;
+  tally.fdROM   = -1;
+  regions = (u8 *)_poolGet( pool, POOL_REGION, 0,
+                            (entry->lengthROM >> REGION_SHIFT) + 1U );
+
+  if ( regions != (u8 *)0 )
+  {
+    _mapRegions( entry->map, entry->lengthROM, regions, 0 );
+    tally.regions = regions;
+  }
+
+  scanSLI( entry->map, entry->lengthROM, fourCC, entry->xr, "", (u32)0,
+           &tally );
+
+  if ( entry->index.isTruncated != 0 )
+  {
+    _dropROM( entry );
+    return (struct entry *)0;
+  }
+
+  entry->bytes = entry->lengthROM + (u32)sizeof(struct entry) +
+                 (u32)sizeof(struct hit) * entry->index.capacity;
+  return entry;
+}
+
+
+
+static struct entry *_acquireROM( const char *path, struct pool *pool )
+{
+  struct stat   status;
+  struct entry *entry;
+  struct entry *loaded;
+
+  if ( stat( path, &status ) != 0 )
+  {
+    return (struct entry *)0;
+  }
+
+  pthread_mutex_lock( &server.lock );
+  server.requests++;
+
+  if ( (entry = _findROM( path, &status )) != (struct entry *)0 )
+  {
+    server.cacheHits++;
+    pthread_mutex_unlock( &server.lock );
+    return entry;
+  }
+
+  server.cacheMisses++;
+  pthread_mutex_unlock( &server.lock );
+
+  TRACE_BEGIN( TRACE_LOAD, 0, 0 );
+  loaded = _loadROM( path, &status, pool );
+  TRACE_END( TRACE_LOAD, 0, 0 );
+
+  if ( loaded == (struct entry *)0 )
+  {
+    METER_ADD( failures, 1 );
+    return (struct entry *)0;
+  }
+
+  METER_ADD( roms, 1 );
+
+  /*------------------------------------------------------------
+  Another worker may have loaded the same ROM in the meantime.
+  ------------------------------------------------------------*/
+  pthread_mutex_lock( &server.lock );
+
+  if ( (entry = _findROM( path, &status )) == (struct entry *)0 )
+  {
+    entry          = loaded;
+    loaded         = (struct entry *)0;
+    entry->users   = 1;
+    entry->lastUse = ++server.clock;
+    entry->next    = server.entries;
+    server.entries = entry;
+    server.bytes  += entry->bytes;
+    _trimCache();
+  }
+
+  pthread_mutex_unlock( &server.lock );
+
+  if ( loaded != (struct entry *)0 )
+  {
+    _dropROM( loaded );
+  }
+
+  return entry;
+}
+
+
+
+static void _releaseROM( struct entry *entry )
+{
+  pthread_mutex_lock( &server.lock );
+
+  if ( (--entry->users == 0) && (entry->isStale != 0) )
+  {
+    _dropROM( entry );
+  }
+  else
+  {
+    _trimCache();
+  }
+
+  pthread_mutex_unlock( &server.lock );
+  return;
+}
+
+
+
+static const struct hit *_findHit( const struct index *index,
+                                   const u32 offset )
+{
+  u32 low  = 0;
+  u32 high = index->count;
+
+  while ( low < high )
+  {
+    u32 middle = low + ((high - low) >> 1);
+
+    if ( index->hits[middle].offset < offset )
+    {
+      low = middle + 1U;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  if ( (low < index->count) && (index->hits[low].offset == offset) )
+  {
+    return &index->hits[low];
+  }
+
+  return (const struct hit *)0;
+}
+
+
+
+static int _recvAll( const int fd, void *data, u32 length )
+{
+  u8 *bytes = (u8 *)data;
+
+  while ( length != 0 )
+  {
+    ssize_t size = recv( fd, bytes, length, 0 );
+
+    if ( size <= 0 )
+    {
+      if ( (size < 0) && (errno == EINTR) )
+      {
+        continue;
+      }
+
+      return 1;
+    }
+
+    bytes  += size;
+    length -= (u32)size;
+  }
+
+  return 0;
+}
+
+static int _sendAll( const int fd, const void *data, u32 length )
+{
+  const u8 *bytes = (const u8 *)data;
+
+  while ( length != 0 )
+  {
+    ssize_t size = send( fd, bytes, length, MSG_NOSIGNAL );
+
+    if ( size <= 0 )
+    {
+      if ( (size < 0) && (errno == EINTR) )
+      {
+        continue;
+      }
+
+      return 1;
+    }
+
+    bytes  += size;
+    length -= (u32)size;
+  }
+
+  return 0;
+}
+
+static int _sendReply( const int fd, const u32 code,
+                       const void *payload, u32 length )
+{
+  u32 header[2];
+
+  if ( code != SRV_OK )
+  {
+    length = 0;
+  }
+
+  header[0] = _swap32( code );
+  header[1] = _swap32( length );
+
+  return    (_sendAll( fd, header, sizeof(header) ) != 0)
+         || (_sendAll( fd, payload, length ) != 0);
+}
+
+
+
+/*------------------------------------------------------------------
+Whether the copy of a block made for a request still walks, to the
+"sizeDecoded" it was indexed with. Any client may name any file, and
+it may have changed since it was indexed, so nothing is handed to
+"decbuf" on the strength of the index alone.
+------------------------------------------------------------------*/
+static int _isWalkable( const u8 *block, const u32 blockLength,
+                        const u32 magic, const u32 sizeDecoded )
+{
+  const struct format *format = _getFormatInfo( magic );
+  u32 walked;
+  int measured;
+
+  if ( format->measure == 0 )
+  {
+    measured = _walkSMSR( block, 0, blockLength, 0 );
+  }
+  else
+  {
+    measured = format->measure( block, 0, blockLength, 0, magic,
+                                &walked, (struct shape *)0 );
+  }
+
+  return    (measured == EXIT_SUCCESS)
+         && (format->getSize( block, (u32)0, (u32)0 ) == sizeDecoded);
+}
+
+
+
+/*------------------------------------------------------------------
+Answers one request on "fd". Returns non-zero once the connection
+should be closed, whether by the client or for a malformed request.
+------------------------------------------------------------------*/
+static int _serveRequest( const int fd, struct pool *pool )
+{
+  char path[PPATH_MAX];
+  u32  request[5];
+  u32  code   = SRV_OK;
+  u32  length = 0;
+  u32  i      = 0;
+  const u8 *payload = (const u8 *)0;
+  const struct hit *hit;
+  struct entry *entry;
+  int result;
+
+  if ( _recvAll( fd, request, sizeof(request) ) != 0 )
+  {
+    return 1;
+  }
+
+  while ( i < 5 )
+  {
+    request[i] = _swap32( request[i] );
+    ++i;
+  }
+
+  if ( (request[4] == 0) || (request[4] >= PPATH_MAX) )
+  {
+    _sendReply( fd, SRV_BAD, (const void *)0, 0 );
+    return 1;
+  }
+
+  if ( _recvAll( fd, path, request[4] ) != 0 )
+  {
+    return 1;
+  }
+
+  path[request[4]] = '\0';
+
+  if ( (request[0] < SRV_LIST) || (request[0] > SRV_DECODE) )
+  {
+    return _sendReply( fd, SRV_BAD, (const void *)0, 0 );
+  }
+
+  if ( (entry = _acquireROM( path, pool )) == (struct entry *)0 )
+  {
+    return _sendReply( fd, SRV_NOROM, (const void *)0, 0 );
+  }
+
+  if ( request[0] == SRV_LIST )
+  {
+    u32 *records = (u32 *)_poolGet( pool, POOL_LIST, 0,
+                                    (entry->index.count << 4) + 4U );
+
+    if ( records == (u32 *)0 )
+    {
+      code = SRV_NOMEMORY;
+    }
+    else
+    {
+      for ( i = 0; i < entry->index.count; ++i )
+      {
+        hit = &entry->index.hits[i];
+        records[(i << 2)     ] = _swap32( hit->offset );
+        records[(i << 2) + 1U] =
+          _swap32( _getFormatInfo( hit->magic )->tag );
+        records[(i << 2) + 2U] = _swap32( hit->raw );
+        records[(i << 2) + 3U] = _swap32( hit->decoded );
+      }
+
+      payload = (const u8 *)records;
+      length  = entry->index.count << 4;
+    }
+  }
+  else
+  {
+    if ( (hit = _findHit( &entry->index, request[1] )) == 0 )
+    {
+      code = SRV_NOBLOCK;
+    }
+    else
+    {
+      u8 *block = _getHitBlock( entry->map, entry->xr, entry->quirk,
+                                hit, pool );
+
+      if ( block == (u8 *)0 )
+      {
+        code = SRV_NOMEMORY;
+      }
+      else
+      {
+        if ( request[0] == SRV_EXTRACT )
+        {
+          payload = block;
+          length  = hit->raw;
+        }
+        else
+        {
+          u8 *dst = (u8 *)_poolGet( pool, POOL_DECODED, 0, hit->decoded );
+
+          if ( dst == (u8 *)0 )
+          {
+            code = SRV_NOMEMORY;
+          }
+          else
+          {
+            TRACE_BEGIN( TRACE_DECODE, hit->offset, hit->magic );
+            if ( _isWalkable( block, hit->raw, hit->magic, hit->decoded ) )
+            {
+              _decodeBlock( block, &dst, hit->magic, hit->decoded );
+            }
+            else
+            {
+              dst = (u8 *)0;
+            }
+            TRACE_END( TRACE_DECODE, hit->offset, hit->magic );
+
+            if ( dst == (u8 *)0 )
+            {
+              code = SRV_NODECODE;
+            }
+            else
+            {
+              u32 start = (request[2] < hit->decoded) ?
+                          request[2] : hit->decoded;
+
+              length  = hit->decoded - start;
+              payload = &dst[start];
+
+              if ( (request[3] != 0) && (request[3] < length) )
+              {
+                length = request[3];
+              }
+            }
+          }
+        }
+      }
+    }
+  }
+
+  result = _sendReply( fd, code, payload, length );
+  _releaseROM( entry );
+  return result;
+}
+
+
+
+/*---------------------------------------------------------------
+Each worker has its own pool, and serves one connection at a time
+until the client hangs up; "argument" is its slot in "active".
+---------------------------------------------------------------*/
+static void *_serveWorker( void *argument )
+{
+  int *active = (int *)argument;
+  struct pool pool;
+  int fd;
+
+  memset( &pool, 0, sizeof(pool) );
+
+  for ( ;; )
+  {
+    pthread_mutex_lock( &server.lock );
+
+    while ( (server.queueCount == 0) && (server.isStopping == 0) )
+    {
+      pthread_cond_wait( &server.waiting, &server.lock );
+    }
+
+    if ( server.queueCount == 0 )
+    {
+      pthread_mutex_unlock( &server.lock );
+      break;
+    }
+
+    fd = server.queue[server.queueHead];
+    server.queueHead = (server.queueHead + 1U) % SRV_QUEUE;
+    server.queueCount--;
+    *active = fd;
+    pthread_mutex_unlock( &server.lock );
+
+    while ( _serveRequest( fd, &pool ) == 0 )
+    {
+      ;
+    }
+
+    pthread_mutex_lock( &server.lock );
+    *active = -1;
+    pthread_mutex_unlock( &server.lock );
+    close( fd );
+  }
+
+  _poolFree( &pool );
+  return (void *)0;
+}
+
+
+
+static void _stopServing( int signal )
+{
+  (void)signal;
+  server.isSignalled = 1;
+  return;
+}
+
+
+
+/*-------------------------------------------------------------------
+Serves on "server.path" until SIGINT or SIGTERM. ROMs named on the
+command line are loaded into the cache before the first connection.
+-------------------------------------------------------------------*/
+static int serveSLI( const char **paths, const u32 count )
+{
+  struct sockaddr_un address;
+  struct sigaction   action;
+  struct stat        status;
+  struct pollfd      listening;
+  pthread_t workers[THREADS_MAX];
+  sigset_t  signals;
+  sigset_t  waiting;
+  struct pool pool;
+  mode_t mask;
+  u32 started = 0;
+  u32 i       = 0;
+  int listener;
+  int isBound = 0;
+
+  if ( strlen( server.path ) >= sizeof(address.sun_path) )
+  {
+    fprintf( STATUS, "\n>>> Socket path is too long!\n\n" );
+    return EXIT_FAILURE;
+  }
+
+  memset( &address, 0, sizeof(address) );
+  address.sun_family = AF_UNIX;
+  strcpy( address.sun_path, server.path );
+
+  /*-------------------------------------------------------
+  Only a socket, as left behind by an earlier run, is ever
+  replaced; any other file at the path is an error.
+  -------------------------------------------------------*/
+  if ( (lstat( server.path, &status ) == 0) && S_ISSOCK( status.st_mode ) )
+  {
+    unlink( server.path );
+  }
+
+  /*-------------------------------------------------------
+  Whoever can connect can have any file the server can read
+  decoded, so the socket is made for its owner alone.
+  -------------------------------------------------------*/
+  if ( (listener = socket( AF_UNIX, SOCK_STREAM, 0 )) >= 0 )
+  {
+    mask    = umask( 077 );
+    isBound = (bind( listener, (struct sockaddr *)&address,
+                     sizeof(address) ) == 0);
+    umask( mask );
+  }
+
+  if ( (isBound == 0) || (listen( listener, SOMAXCONN ) != 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to listen on:\n>>> \"%s\"\n\n",
+                     server.path );
+
+    if ( listener >= 0 )
+    {
+      close( listener );
+    }
+
+    return EXIT_FAILURE;
+  }
+
+  memset( &action, 0, sizeof(action) );
+  sigemptyset( &action.sa_mask );
+  action.sa_handler = _stopServing;
+  sigaction( SIGINT,  &action, (struct sigaction *)0 );
+  sigaction( SIGTERM, &action, (struct sigaction *)0 );
+  action.sa_handler = SIG_IGN;
+  sigaction( SIGPIPE, &action, (struct sigaction *)0 );
+
+  /*-------------------------------------------------------------
+  The stop signals are only let through while "ppoll" waits, so
+  none can slip in between checking "isSignalled" and waiting.
+  -------------------------------------------------------------*/
+  sigemptyset( &signals );
+  sigaddset( &signals, SIGINT );
+  sigaddset( &signals, SIGTERM );
+  pthread_sigmask( SIG_BLOCK, &signals, &waiting );
+  sigdelset( &waiting, SIGINT );
+  sigdelset( &waiting, SIGTERM );
+
+  pthread_mutex_init( &server.lock, (const pthread_mutexattr_t *)0 );
+  pthread_cond_init( &server.waiting, (const pthread_condattr_t *)0 );
+  memset( &pool, 0, sizeof(pool) );
+
+  for ( i = 0; i < THREADS_MAX; ++i )
+  {
+    server.active[i] = -1;
+  }
+
+  __atomic_store_n( &server.isServing, 1U, __ATOMIC_RELEASE );
+  i = 0;
+
+  while ( i < count )
+  {
+    struct entry *entry = _acquireROM( paths[i], &pool );
+
+    if ( entry == (struct entry *)0 )
+    {
+      fprintf( STATUS, ">>> Unable to load: \"%s\"\n", paths[i] );
+    }
+    else
+    {
+      _releaseROM( entry );
+    }
+
+    ++i;
+  }
+
+  _poolFree( &pool );
+
+  while ( started < threads )
+  {
+    if ( pthread_create( &workers[started], (const pthread_attr_t *)0,
+                         _serveWorker, &server.active[started] ) != 0 )
+    {
+      break;
+    }
+
+    ++started;
+  }
+
+  fprintf( STATUS, "# Serving on \"%s\" with %u workers.\n",
+                   server.path, started );
+  fflush( STATUS );
+  listening.fd     = listener;
+  listening.events = POLLIN;
+
+  while ( (server.isSignalled == 0) && (started != 0) )
+  {
+    int fd;
+
+    if ( ppoll( &listening, 1, (const struct timespec *)0, &waiting ) <= 0 )
+    {
+      continue;
+    }
+
+    if ( (fd = accept( listener, (struct sockaddr *)0,
+                       (socklen_t *)0 )) < 0 )
+    {
+      continue;
+    }
+
+    pthread_mutex_lock( &server.lock );
+
+    if ( server.queueCount == SRV_QUEUE )
+    {
+      close( fd );
+    }
+    else
+    {
+      server.queue[(server.queueHead + server.queueCount) % SRV_QUEUE] = fd;
+      server.queueCount++;
+      pthread_cond_signal( &server.waiting );
+    }
+
+    pthread_mutex_unlock( &server.lock );
+  }
+
+  /*------------------------------------------------------------
+  Connections still open are shut down under the workers, which
+  then find the queue empty and return.
+  ------------------------------------------------------------*/
+  pthread_mutex_lock( &server.lock );
+  server.isStopping = 1;
+
+  for ( i = 0; i < started; ++i )
+  {
+    if ( server.active[i] >= 0 )
+    {
+      shutdown( server.active[i], SHUT_RDWR );
+    }
+  }
+
+  while ( server.queueCount != 0 )
+  {
+    close( server.queue[server.queueHead] );
+    server.queueHead = (server.queueHead + 1U) % SRV_QUEUE;
+    server.queueCount--;
+  }
+
+  pthread_cond_broadcast( &server.waiting );
+  pthread_mutex_unlock( &server.lock );
+
+  for ( i = 0; i < started; ++i )
+  {
+    pthread_join( workers[i], (void **)0 );
+  }
+
+  close( listener );
+  unlink( server.path );
+
+  while ( server.entries != (struct entry *)0 )
+  {
+    struct entry *entry = server.entries;
+
+    server.entries = entry->next;
+    _dropROM( entry );
+  }
+
+  __atomic_store_n( &server.isServing, 0U, __ATOMIC_RELEASE );
+  pthread_cond_destroy( &server.waiting );
+  pthread_mutex_destroy( &server.lock );
+  fprintf( STATUS, "# Requests: %u\n# Cache: %u hits, %u misses\n",
+                   server.requests, server.cacheHits, server.cacheMisses );
+  return (started != 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+#endif
+
+
+
+#ifdef XSLI_WATCH
+/*---------------------------------------------------------------------
+"--watch" processes each ROM that turns up in a directory just as if
+it had been named on the command line, as soon as it has been written
+out in full, i.e. closed after writing or moved in, on "-j" workers.
+Whatever is in the directory already is caught up on at the start.
+
+What has been processed is kept in WATCH_RECORD within the directory,
+a line for each ROM, so that a restart takes up where the last run
+left off; a ROM is only taken again once its size or time of change
+differ from those recorded. "+" marks a ROM done, "!" one that failed:
+
+  "+"|"!" SIZE SECONDS NANOSECONDS NAME
+
+Only files named as ROMs are taken [.z64, .v64, .n64, .rom and .bin],
+and never the "_bs.N64" files of "-o", nor anything else written out,
+as blocks are named after their ROM, e.g. "game.z64_0x1400.szs".
+---------------------------------------------------------------------*/
+#define WATCH_RECORD ".xsli_watch"
+#define WATCH_EVENTS (IN_CLOSE_WRITE | IN_MOVED_TO)
+
+struct done
+{
+  char *name;
+  unsigned long size;
+  long seconds;
+  long nanoseconds;
+};
+
+struct queued
+{
+  struct queued *next;
+  char *name;
+  unsigned isDirty;
+};
+
+static struct
+{
+  const char *path;
+  FILE *RECORD;
+  struct done *done;
+  u32 countDone;
+  u32 maxDone;
+  /*----------------------------------------------------------
+  Names waiting for a worker, oldest first, and those a worker
+  has, which "lock" also guards, with the record and the counts
+  below. A name is only ever in one of the two lists, so that
+  no two workers have the same ROM at once; one written again
+  while a worker has it is marked "isDirty" instead, and taken
+  again once the worker is done with it.
+  ----------------------------------------------------------*/
+  struct queued *head;
+  struct queued *tail;
+  struct queued *busy;
+  u32 processed;
+  u32 failed;
+  u32 skipped;
+  unsigned isStopping;
+  pthread_mutex_t lock;
+  pthread_cond_t waiting;
+  volatile sig_atomic_t isSignalled;
+}
+watch;
+
+
+
+static int _isROMName( const char *name )
+{
+  static const char *extensions[] = { ".z64", ".v64", ".n64", ".rom",
+                                      ".bin" };
+  size_t length = strlen( name );
+  u32 i;
+  u32 j;
+
+  if ( (length < 5U) || (name[0] == '.') )
+  {
+    return 0;
+  }
+
+  if ( (length >= 7U) && (strcmp( &name[length - 7U], "_bs.N64" ) == 0) )
+  {
+    return 0;
+  }
+
+  for ( i = 0; i < (sizeof(extensions) / sizeof(extensions[0])); ++i )
+  {
+    for ( j = 0; j < 4U; ++j )
+    {
+      if ( tolower( (u8)name[length - 4U + j] ) != extensions[i][j] )
+      {
+        break;
+      }
+    }
+
+    if ( j == 4U )
+    {
+      return 1;
+    }
+  }
+
+  return 0;
+}
+
+
+
+/*-------------------------------------------------------------
+The entry recorded for "name", if any; "watch.lock" is held, or
+there are no workers yet.
+-------------------------------------------------------------*/
+static struct done *_findDone( const char *name )
+{
+  u32 i;
+
+  for ( i = 0; i < watch.countDone; ++i )
+  {
+    if ( strcmp( watch.done[i].name, name ) == 0 )
+    {
+      return &watch.done[i];
+    }
+  }
+
+  return (struct done *)0;
+}
+
+
+
+static int _noteDone( const char *name, const unsigned long size,
+                      const long seconds, const long nanoseconds )
+{
+  struct done *done = _findDone( name );
+
+  if ( done == (struct done *)0 )
+  {
+    if ( watch.countDone == watch.maxDone )
+    {
+      u32 most = (watch.maxDone != 0) ? (watch.maxDone << 1) : 64U;
+      struct done *more = (struct done *)
+                          realloc( watch.done, most * sizeof(struct done) );
+
+      if ( more == (struct done *)0 )
+      {
+        return 1;
+      }
+
+      watch.done    = more;
+      watch.maxDone = most;
+    }
+
+    done = &watch.done[watch.countDone];
+
+    if ( (done->name = (char *)malloc( strlen( name ) + 1U )) == (char *)0 )
+    {
+      return 1;
+    }
+
+    strcpy( done->name, name );
+    watch.countDone++;
+  }
+
+  done->size        = size;
+  done->seconds     = seconds;
+  done->nanoseconds = nanoseconds;
+  return 0;
+}
+
+
+
+/*--------------------------------------------------------------
+Reads what earlier runs recorded, then leaves the record open to
+be added to; lines that don't parse are passed over.
+--------------------------------------------------------------*/
+static int _openRecord( void )
+{
+  char line[FILENAME_MAX + 80];
+  char path[PPATH_MAX + 16];
+
+  if ( strlen( watch.path ) >= PPATH_MAX )
+  {
+    fprintf( STATUS, "\n>>> Directory path is too long!\n\n" );
+    return EXIT_FAILURE;
+  }
+
+  sprintf( path, "%s/%s", watch.path, WATCH_RECORD );
+
+  if ( (watch.RECORD = fopen( path, "a+" )) == (FILE *)0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to open:\n>>> \"%s\"\n\n", path );
+    return EXIT_FAILURE;
+  }
+
+  rewind( watch.RECORD );
+
+  while ( fgets( line, (int)sizeof(line), watch.RECORD ) != (char *)0 )
+  {
+    unsigned long size;
+    long seconds;
+    long nanoseconds;
+    char mark;
+    int name = 0;
+    size_t length = strlen( line );
+
+    if ( (length == 0) || (line[length - 1U] != '\n') )
+    {
+      continue;
+    }
+
+    line[length - 1U] = '\0';
+
+    if (    (sscanf( line, "%c %lu %ld %ld %n", &mark, &size,
+                     &seconds, &nanoseconds, &name ) == 4)
+         && ((mark == '+') || (mark == '!')) && (name > 0)
+         && (line[name] != '\0')
+         && (_noteDone( &line[name], size, seconds, nanoseconds ) != 0) )
+    {
+      fprintf( STATUS,
+               "\n>>> Unable to allocate work RAM for the record!\n\n" );
+      return EXIT_FAILURE;
+    }
+  }
+
+  fseek( watch.RECORD, 0, SEEK_END );
+  return EXIT_SUCCESS;
+}
+
+
+
+/*-----------------------------------------
+Queues "queued" last; "watch.lock" is held.
+-----------------------------------------*/
+static void _append( struct queued *queued )
+{
+  queued->next = (struct queued *)0;
+
+  if ( watch.tail != (struct queued *)0 )
+  {
+    watch.tail->next = queued;
+  }
+  else
+  {
+    watch.head = queued;
+  }
+
+  watch.tail = queued;
+  pthread_cond_signal( &watch.waiting );
+  return;
+}
+
+
+
+static void _enqueue( const char *name )
+{
+  struct queued *queued;
+
+  if ( _isROMName( name ) == 0 )
+  {
+    return;
+  }
+
+  pthread_mutex_lock( &watch.lock );
+
+  for ( queued = watch.head; queued != (struct queued *)0;
+        queued = queued->next )
+  {
+    if ( strcmp( queued->name, name ) == 0 )
+    {
+      pthread_mutex_unlock( &watch.lock );
+      return;
+    }
+  }
+
+  for ( queued = watch.busy; queued != (struct queued *)0;
+        queued = queued->next )
+  {
+    if ( strcmp( queued->name, name ) == 0 )
+    {
+      queued->isDirty = 1;
+      pthread_mutex_unlock( &watch.lock );
+      return;
+    }
+  }
+
+  if (    ((queued = (struct queued *)malloc( sizeof(struct queued) ))
+           == (struct queued *)0)
+       || ((queued->name = (char *)malloc( strlen( name ) + 1U ))
+           == (char *)0) )
+  {
+    free( queued );
+    pthread_mutex_unlock( &watch.lock );
+    fprintf( STATUS, ">>> Unable to queue: \"%s\"\n", name );
+    return;
+  }
+
+  strcpy( queued->name, name );
+  queued->isDirty = 0;
+  _append( queued );
+  pthread_mutex_unlock( &watch.lock );
+  return;
+}
+
+
+
+static void _sweepWatched( void )
+{
+  DIR *directory = opendir( watch.path );
+  struct dirent *entry;
+
+  if ( directory == (DIR *)0 )
+  {
+    return;
+  }
+
+  while ( (entry = readdir( directory )) != (struct dirent *)0 )
+  {
+    _enqueue( entry->d_name );
+  }
+
+  closedir( directory );
+  return;
+}
+
+
+
+/*------------------------------------------------------------------
+Takes ROMs from the queue until it is empty and "isStopping" is set.
+Each ROM's messages are kept aside while it is processed, then put
+out whole, so that those of ROMs processed at once are never mixed.
+------------------------------------------------------------------*/
+static void *_watchWorker( void *argument )
+{
+  struct pool pool;
+
+  (void)argument;
+  memset( &pool, 0, sizeof(pool) );
+
+  for ( ;; )
+  {
+    struct queued *queued;
+    struct queued **link;
+    struct stat    status;
+    char   path[PPATH_MAX];
+    char  *text = (char *)0;
+    size_t size = 0;
+    int    code;
+
+    pthread_mutex_lock( &watch.lock );
+
+    while ( (watch.head == (struct queued *)0) && (watch.isStopping == 0) )
+    {
+      pthread_cond_wait( &watch.waiting, &watch.lock );
+    }
+
+    if ( (queued = watch.head) == (struct queued *)0 )
+    {
+      pthread_mutex_unlock( &watch.lock );
+      break;
+    }
+
+    if ( (watch.head = queued->next) == (struct queued *)0 )
+    {
+      watch.tail = (struct queued *)0;
+    }
+
+    queued->next = watch.busy;
+    watch.busy   = queued;
+    pthread_mutex_unlock( &watch.lock );
+
+    /*------------------------------------------------------------
+    Room for "processROM" to name blocks after the path, with "_"
+    appended, as well as for the path itself.
+    ------------------------------------------------------------*/
+    if ( (strlen( watch.path ) + strlen( queued->name ) + 3U) > PPATH_MAX )
+    {
+      goto next;
+    }
+
+    strcpy( path, watch.path );
+    strcat( path, "/" );
+    strcat( path, queued->name );
+
+    if ( (stat( path, &status ) != 0) || !S_ISREG( status.st_mode ) )
+    {
+      goto next;
+    }
+
+    pthread_mutex_lock( &watch.lock );
+
+    {
+      const struct done *done = _findDone( queued->name );
+
+      if (    (done != (const struct done *)0)
+           && (done->size == (unsigned long)status.st_size)
+           && (done->seconds == (long)status.st_mtim.tv_sec)
+           && (done->nanoseconds == (long)status.st_mtim.tv_nsec) )
+      {
+        watch.skipped++;
+        pthread_mutex_unlock( &watch.lock );
+        goto next;
+      }
+    }
+
+    pthread_mutex_unlock( &watch.lock );
+
+    if ( (statusLog = open_memstream( &text, &size )) != (FILE *)0 )
+    {
+      fprintf( statusLog, "# ROM: \"%s\"\n", path );
+    }
+    else
+    {
+      fprintf( STATUS, "# ROM: \"%s\"\n", path );
+    }
+
+    code = processROM( path, &pool );
+
+    if ( code != EXIT_SUCCESS )
+    {
+      METER_ADD( failures, 1 );
+    }
+    else
+    {
+      METER_ADD( roms, 1 );
+    }
+
+    if ( statusLog != (FILE *)0 )
+    {
+      fclose( statusLog );
+      statusLog = (FILE *)0;
+      fwrite( text, sizeof(char), size, statusFile );
+      fflush( statusFile );
+      free( text );
+    }
+
+    /*---------------------------------------------------------
+    The ROM is recorded as it was found; one changed since was
+    written again, and so is marked to be taken anew.
+    ---------------------------------------------------------*/
+    pthread_mutex_lock( &watch.lock );
+
+    if ( code != EXIT_SUCCESS )
+    {
+      watch.failed++;
+    }
+    else
+    {
+      watch.processed++;
+    }
+
+    if (    (strchr( queued->name, '\n' ) == (char *)0)
+         && (_noteDone( queued->name, (unsigned long)status.st_size,
+                        (long)status.st_mtim.tv_sec,
+                        (long)status.st_mtim.tv_nsec ) == 0) )
+    {
+      fprintf( watch.RECORD, "%c %lu %ld %ld %s\n",
+               ((code == EXIT_SUCCESS) ? '+' : '!'),
+               (unsigned long)status.st_size,
+               (long)status.st_mtim.tv_sec, (long)status.st_mtim.tv_nsec,
+               queued->name );
+      fflush( watch.RECORD );
+    }
+
+    pthread_mutex_unlock( &watch.lock );
+
+next:
+    pthread_mutex_lock( &watch.lock );
+    link = &watch.busy;
+
+    while ( *link != queued )
+    {
+      link = &(*link)->next;
+    }
+
+    *link = queued->next;
+
+    if ( (queued->isDirty != 0) && (watch.isStopping == 0) )
+    {
+      queued->isDirty = 0;
+      _append( queued );
+      queued = (struct queued *)0;
+    }
+
+    pthread_mutex_unlock( &watch.lock );
+
+    if ( queued != (struct queued *)0 )
+    {
+      free( queued->name );
+      free( queued );
+    }
+  }
+
+  _poolFree( &pool );
+  return (void *)0;
+}
+
+
+
+static void _stopWatching( int signal )
+{
+  (void)signal;
+  watch.isSignalled = 1;
+  return;
+}
+
+
+
+/*-------------------------------------------------------------------
+Watches "watch.path" until SIGINT or SIGTERM; ROMs being processed
+then are finished, and those still queued are left for the next run.
+-------------------------------------------------------------------*/
+static int watchSLI( void )
+{
+  /*---------------------------------------------------------
+  Room for a few events at their longest, aligned as they are.
+  ---------------------------------------------------------*/
+  u32 events[(4U * (sizeof(struct inotify_event) + FILENAME_MAX + 1U))
+             / sizeof(u32)];
+  struct sigaction action;
+  struct stat      status;
+  struct pollfd    watched;
+  pthread_t workers[THREADS_MAX];
+  sigset_t  signals;
+  sigset_t  waiting;
+  u32 started = 0;
+  u32 i;
+  int code = EXIT_FAILURE;
+
+  if ( (stat( watch.path, &status ) != 0) || !S_ISDIR( status.st_mode ) )
+  {
+    fprintf( STATUS, "\n>>> Not a directory:\n>>> \"%s\"\n\n", watch.path );
+    return EXIT_FAILURE;
+  }
+
+  if ( _openRecord() != EXIT_SUCCESS )
+  {
+    goto err;
+  }
+
+  /*----------------------------------------------------------
+  Watching starts before the directory is swept, so that no
+  ROM can arrive unseen in between. One seen by both is only
+  queued once; if a worker has it already, it is taken again
+  after, and then skipped unless it changed meanwhile.
+  ----------------------------------------------------------*/
+  if (    ((watched.fd = inotify_init()) < 0)
+       || (inotify_add_watch( watched.fd, watch.path, WATCH_EVENTS ) < 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to watch:\n>>> \"%s\"\n\n", watch.path );
+
+    if ( watched.fd >= 0 )
+    {
+      close( watched.fd );
+    }
+
+    goto err;
+  }
+
+  memset( &action, 0, sizeof(action) );
+  sigemptyset( &action.sa_mask );
+  action.sa_handler = _stopWatching;
+  sigaction( SIGINT,  &action, (struct sigaction *)0 );
+  sigaction( SIGTERM, &action, (struct sigaction *)0 );
+  sigemptyset( &signals );
+  sigaddset( &signals, SIGINT );
+  sigaddset( &signals, SIGTERM );
+  pthread_sigmask( SIG_BLOCK, &signals, &waiting );
+  sigdelset( &waiting, SIGINT );
+  sigdelset( &waiting, SIGTERM );
+
+  pthread_mutex_init( &watch.lock, (const pthread_mutexattr_t *)0 );
+  pthread_cond_init( &watch.waiting, (const pthread_condattr_t *)0 );
+
+  /*---------------------------------------------------------
+  The workers are the "-j" threads; each decodes serially.
+  ---------------------------------------------------------*/
+  isSplitting = 0;
+
+  while ( started < threads )
+  {
+    if ( pthread_create( &workers[started], (const pthread_attr_t *)0,
+                         _watchWorker, (void *)0 ) != 0 )
+    {
+      break;
+    }
+
+    ++started;
+  }
+
+  fprintf( STATUS, "# Watching \"%s\" with %u workers.\n",
+                   watch.path, started );
+  fflush( STATUS );
+  _sweepWatched();
+  watched.events = POLLIN;
+
+  while ( (watch.isSignalled == 0) && (started != 0) )
+  {
+    ssize_t length;
+    char   *event;
+
+    if ( ppoll( &watched, 1, (const struct timespec *)0, &waiting ) <= 0 )
+    {
+      continue;
+    }
+
+    if ( (length = read( watched.fd, events, sizeof(events) )) <= 0 )
+    {
+      continue;
+    }
+
+    for ( event = (char *)events; event < &((char *)events)[length];
+          event += sizeof(struct inotify_event) +
+                   ((struct inotify_event *)event)->len )
+    {
+      const struct inotify_event *happened =
+        (const struct inotify_event *)event;
+
+      /*------------------------------------------------------
+      Events lost to a full kernel queue are made up for by
+      sweeping the directory once more.
+      ------------------------------------------------------*/
+      if ( (happened->mask & IN_Q_OVERFLOW) != 0 )
+      {
+        _sweepWatched();
+      }
+      else if ( (happened->len != 0) && ((happened->mask & IN_ISDIR) == 0) )
+      {
+        _enqueue( happened->name );
+      }
+    }
+  }
+
+  pthread_mutex_lock( &watch.lock );
+  watch.isStopping = 1;
+
+  while ( watch.head != (struct queued *)0 )
+  {
+    struct queued *queued = watch.head;
+
+    watch.head = queued->next;
+    free( queued->name );
+    free( queued );
+  }
+
+  watch.tail = (struct queued *)0;
+  pthread_cond_broadcast( &watch.waiting );
+  pthread_mutex_unlock( &watch.lock );
+
+  for ( i = 0; i < started; ++i )
+  {
+    pthread_join( workers[i], (void **)0 );
+  }
+
+  close( watched.fd );
+  pthread_cond_destroy( &watch.waiting );
+  pthread_mutex_destroy( &watch.lock );
+  fprintf( STATUS, "# Processed: %u\n# Failed: %u\n# Skipped: %u\n",
+                   watch.processed, watch.failed, watch.skipped );
+  code = (started != 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+
+err:
+  if ( watch.RECORD != (FILE *)0 )
+  {
+    fclose( watch.RECORD );
+  }
+
+  for ( i = 0; i < watch.countDone; ++i )
+  {
+    free( watch.done[i].name );
+  }
+
+  free( watch.done );
+  return code;
+}
+#endif
+
+
+
+#ifdef XSLI_METRICS
+/*-------------------------------------------------------------------
+"-x" is sampled once a second by a thread of its own, which writes
+the metrics file [Prometheus text format] under a temporary name and
+renames it into place, so that a scraper never reads half of one,
+and redraws the progress line when stderr is a terminal.
+-------------------------------------------------------------------*/
+static struct
+{
+  pthread_t thread;
+  pthread_mutex_t lock;
+  pthread_cond_t  wake;
+  struct timespec start;
+  unsigned isDone;
+  unsigned isLive;
+  unsigned isRunning;
+}
+sampler;
+
+static void _sumMeters( struct meter *total )
+{
+  const struct meter *meter;
+  int i;
+  int j;
+
+  memset( total, 0, sizeof(*total) );
+
+  for ( meter = __atomic_load_n( &metrics.meters, __ATOMIC_ACQUIRE );
+        meter != (const struct meter *)0; meter = meter->next )
+  {
+#define METER_SUM( field ) \
+        total->field += __atomic_load_n( &meter->field, __ATOMIC_RELAXED )
+    METER_SUM( roms );
+    METER_SUM( failures );
+    METER_SUM( scanned );
+    METER_SUM( decoded );
+    METER_SUM( written );
+
+    for ( i = 0; i < FORMAT_SLOTS; ++i )
+    {
+      METER_SUM( candidates[i] );
+      METER_SUM( hits[i] );
+      METER_SUM( rejects[i] );
+      METER_SUM( filtered[i] );
+    }
+
+    for ( i = 0; i < 2; ++i )
+    {
+      METER_SUM( latencySum[i] );
+
+      for ( j = 0; j < METER_BUCKETS; ++j )
+      {
+        METER_SUM( latency[i][j] );
+      }
+    }
+#undef METER_SUM
+  }
+
+  return;
+}
+
+static void _putCounter( FILE *METRICS, const char *name, const char *help,
+                         const char *type, const unsigned long value )
+{
+  fprintf( METRICS, "# HELP xsli_%s %s\n# TYPE xsli_%s %s\nxsli_%s %lu\n",
+                    name, help, name, type, name, value );
+  return;
+}
+
+static void _putFormats( FILE *METRICS, const char *name, const char *help,
+                         const unsigned long values[FORMAT_SLOTS] )
+{
+  int i;
+
+  fprintf( METRICS, "# HELP xsli_%s %s\n# TYPE xsli_%s counter\n",
+                    name, help, name );
+
+  for ( i = 0; i < FORMAT_SLOTS; ++i )
+  {
+    fprintf( METRICS, "xsli_%s{format=\"%s\"} %lu\n",
+                      name, formats[i].name, values[i] );
+  }
+
+  return;
+}
+
+static void _putHistogram( FILE *METRICS, const char *name, const char *help,
+                           const unsigned long buckets[METER_BUCKETS],
+                           const unsigned long sum )
+{
+  static const char *bounds[METER_BUCKETS] =
+  {
+    "0.0001", "0.001", "0.01", "0.1", "1", "+Inf"
+  };
+  unsigned long count = 0;
+  int i;
+
+  fprintf( METRICS, "# HELP xsli_%s %s\n# TYPE xsli_%s histogram\n",
+                    name, help, name );
+
+  for ( i = 0; i < METER_BUCKETS; ++i )
+  {
+    count += buckets[i];
+    fprintf( METRICS, "xsli_%s_bucket{le=\"%s\"} %lu\n",
+                      name, bounds[i], count );
+  }
+
+  fprintf( METRICS, "xsli_%s_sum %.6f\nxsli_%s_count %lu\n",
+                    name, (double)sum / 1.0e6, name, count );
+  return;
+}
+
+static void _putMetrics( const struct meter *total, const u32 queued )
+{
+  char  name[FILENAME_MAX];
+  FILE *METRICS;
+  u32   connections = 0;
+  u32   busy        = 0;
+
+#ifdef XSLI_DAEMON
+  if ( __atomic_load_n( &server.isServing, __ATOMIC_ACQUIRE ) != 0 )
+  {
+    u32 i;
+
+    pthread_mutex_lock( &server.lock );
+    connections = server.queueCount;
+
+    for ( i = 0; i < threads; ++i )
+    {
+      busy += (server.active[i] >= 0);
+    }
+
+    pthread_mutex_unlock( &server.lock );
+  }
+#endif
+
+  if ( (strlen( metrics.path ) + 5U) >= FILENAME_MAX )
+  {
+    return;
+  }
+
+  sprintf( name, "%s.tmp", metrics.path );
+
+  if ( (METRICS = fopen( name, "w" )) == (FILE *)0 )
+  {
+    return;
+  }
+
+  _putCounter( METRICS, "roms_processed_total",
+               "ROMs scanned, or loaded while serving.",
+               "counter", total->roms );
+  _putCounter( METRICS, "rom_failures_total",
+               "ROMs that couldn't be read or scanned.",
+               "counter", total->failures );
+  _putCounter( METRICS, "scanned_bytes_total",
+               "Bytes of ROMs and decoded data scanned.",
+               "counter", total->scanned );
+  _putFormats( METRICS, "candidates_total",
+               "SLI headers found.", total->candidates );
+  _putFormats( METRICS, "hits_total",
+               "Blocks extracted, listed or indexed.", total->hits );
+  _putFormats( METRICS, "rejects_total",
+               "Headers without a valid block behind them.",
+               total->rejects );
+  _putFormats( METRICS, "filtered_total",
+               "Blocks excluded by filters.", total->filtered );
+  _putCounter( METRICS, "decoded_bytes_total",
+               "Bytes of data decoded.", "counter", total->decoded );
+  _putCounter( METRICS, "written_bytes_total",
+               "Bytes written to files or the standard output.",
+               "counter", total->written );
+  _putHistogram( METRICS, "decode_seconds",
+                 "Time taken to decode a block.",
+                 total->latency[0], total->latencySum[0] );
+  _putHistogram( METRICS, "write_seconds",
+                 "Time taken to write a block or its decoded data.",
+                 total->latency[1], total->latencySum[1] );
+  _putCounter( METRICS, "roms_queued",
+               "ROMs given that are yet to be scanned.",
+               "gauge", queued );
+  _putCounter( METRICS, "connections_queued",
+               "Connections waiting for a worker while serving.",
+               "gauge", connections );
+  _putCounter( METRICS, "workers_busy",
+               "Workers serving a connection.", "gauge", busy );
+  fclose( METRICS );
+  rename( name, metrics.path );
+  return;
+}
+
+static void _putProgress( const struct meter *total, const u32 queued,
+                          const struct timespec *now )
+{
+  double seconds = (double)(now->tv_sec - sampler.start.tv_sec) +
+                   (double)(now->tv_nsec - sampler.start.tv_nsec) / 1.0e9;
+  unsigned long hits    = 0;
+  unsigned long rejects = 0;
+  int i;
+
+  for ( i = 0; i < FORMAT_SLOTS; ++i )
+  {
+    hits    += total->hits[i];
+    rejects += total->rejects[i];
+  }
+
+  fprintf( stderr, "\r# ROMs: %lu/%lu | Scanned: %.1f MiB [%.1f MiB/s] | "
+                   "Hits: %lu | Rejects: %lu | Decoded: %.1f MiB\33[K",
+                   total->roms, total->roms + queued,
+                   (double)total->scanned / 1048576.0,
+                   (seconds > 0.0) ?
+                   ((double)total->scanned / 1048576.0 / seconds) : 0.0,
+                   hits, rejects, (double)total->decoded / 1048576.0 );
+  fflush( stderr );
+  return;
+}
+
+static void _sample( void )
+{
+  struct meter    total;
+  struct timespec now;
+  u32 queued = __atomic_load_n( &metrics.romsQueued, __ATOMIC_RELAXED );
+
+  clock_gettime( CLOCK_MONOTONIC, &now );
+  _sumMeters( &total );
+
+  if ( metrics.path != (const char *)0 )
+  {
+    _putMetrics( &total, queued );
+  }
+
+  if ( sampler.isLive != 0 )
+  {
+    _putProgress( &total, queued, &now );
+  }
+
+  return;
+}
+
+static void *_watchRun( void *argument )
+{
+  struct timespec deadline;
+
+  (void)argument;
+  pthread_mutex_lock( &sampler.lock );
+
+  while ( sampler.isDone == 0 )
+  {
+    clock_gettime( CLOCK_REALTIME, &deadline );
+    deadline.tv_sec += 1;
+    pthread_cond_timedwait( &sampler.wake, &sampler.lock, &deadline );
+
+    if ( sampler.isDone == 0 )
+    {
+      _sample();
+    }
+  }
+
+  pthread_mutex_unlock( &sampler.lock );
+  return (void *)0;
+}
+
+/*-------------------------------------------------------------------
+The sampler is started with every signal blocked, so that SIGINT and
+SIGTERM still reach whichever thread waits for them with "-u".
+-------------------------------------------------------------------*/
+static void _startMetrics( void )
+{
+  sigset_t signals;
+  sigset_t previous;
+
+  if ( metrics.isEnabled == 0 )
+  {
+    return;
+  }
+
+  clock_gettime( CLOCK_MONOTONIC, &sampler.start );
+  sampler.isLive = isatty( STDERR_FILENO );
+  pthread_mutex_init( &sampler.lock, (const pthread_mutexattr_t *)0 );
+  pthread_cond_init( &sampler.wake, (const pthread_condattr_t *)0 );
+  sigfillset( &signals );
+  pthread_sigmask( SIG_BLOCK, &signals, &previous );
+  sampler.isRunning = (pthread_create( &sampler.thread,
+                                       (const pthread_attr_t *)0,
+                                       _watchRun, (void *)0 ) == 0);
+  pthread_sigmask( SIG_SETMASK, &previous, (sigset_t *)0 );
+  return;
+}
+
+static void _stopMetrics( void )
+{
+  struct meter *meter;
+
+  if ( metrics.isEnabled == 0 )
+  {
+    return;
+  }
+
+  if ( sampler.isRunning != 0 )
+  {
+    pthread_mutex_lock( &sampler.lock );
+    sampler.isDone = 1;
+    pthread_cond_signal( &sampler.wake );
+    pthread_mutex_unlock( &sampler.lock );
+    pthread_join( sampler.thread, (void **)0 );
+  }
+
+  _sample();
+
+  if ( sampler.isLive != 0 )
+  {
+    fputc( '\n', stderr );
+  }
+
+  pthread_cond_destroy( &sampler.wake );
+  pthread_mutex_destroy( &sampler.lock );
+  metrics.isEnabled = 0;
+
+  while ( metrics.meters != (struct meter *)0 )
+  {
+    meter = metrics.meters;
+    metrics.meters = meter->next;
+    free( meter );
+  }
+
+  meterLocal = (struct meter *)0;
+  return;
+}
+#endif
+
+
+
+#ifdef XSLI_TRACE
+/*-------------------------------------------------------------------
+Writes every thread's events to "trace.path" as Chrome trace JSON,
+which Perfetto and "chrome://tracing" open as one track per thread.
+-------------------------------------------------------------------*/
+static int _putTrace( void )
+{
+  static const char *names[] =
+  {
+    "ROM load", "_orderBytes", "getBlockLength", "decbuf", "writeSLI"
+  };
+  struct traceBuffer *buffer;
+  const char *separator = "";
+  u32 dropped = 0;
+  u32 i;
+  FILE *TRACE;
+
+  if ( (TRACE = fopen( trace.path, "w" )) == (FILE *)0 )
+  {
+    fprintf( STATUS, "\n>>> Unable to create trace file:\n>>> \"%s\"\n\n",
+                     trace.path );
+    return EXIT_FAILURE;
+  }
+
+  fprintf( TRACE, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[" );
+
+  for ( buffer = trace.buffers; buffer != (struct traceBuffer *)0;
+        buffer = buffer->next )
+  {
+    fprintf( TRACE, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\","
+                    "\"pid\":1,\"tid\":%u,"
+                    "\"args\":{\"name\":\"xsli %u\"}}",
+                    separator, buffer->thread, buffer->thread );
+    separator = ",";
+
+    for ( i = 0; i < buffer->count; ++i )
+    {
+      const struct event *event = &buffer->events[i];
+
+      fprintf( TRACE, ",\n{\"name\":\"%s\",\"cat\":\"xsli\",\"ph\":\"%c\","
+                      "\"ts\":%.3f,\"pid\":1,\"tid\":%u",
+                      names[event->kind], (char)event->phase,
+                      event->time, buffer->thread );
+
+      if ( event->magic != 0 )
+      {
+        fprintf( TRACE, ",\"args\":{\"offset\":\"0x%X\",\"format\":\"%s\"}",
+                        event->offset, _getFormatName( event->magic ) );
+      }
+
+      fputc( '}', TRACE );
+    }
+
+    dropped += buffer->dropped;
+  }
+
+  fprintf( TRACE, "\n]}\n" );
+  fclose( TRACE );
+  trace.path = (const char *)0;
+  traceLocal = (struct traceBuffer *)0;
+
+  while ( trace.buffers != (struct traceBuffer *)0 )
+  {
+    buffer = trace.buffers;
+    trace.buffers = buffer->next;
+    free( buffer->events );
+    free( buffer );
+  }
+
+  if ( dropped != 0 )
+  {
+    fprintf( STATUS, "# Trace events dropped: %u\n", dropped );
+  }
+
+  return EXIT_SUCCESS;
+}
+#endif
+
+
+
+int main( const int argc, const char *argv[] )
+{
+  if ( argc < 2 )
+  {
+    _usage();
+    return EXIT_FAILURE;
+  }
+  else
+  {
+    const char **paths = (const char **)0;
+    struct pool pool;
+    u32 count = 0;
+    u32 i     = 0;
+    int code  = EXIT_SUCCESS;
+
+    if ( (paths = _processArgs( argc, argv, &count )) == (const char **)0 )
+    {
+      return EXIT_FAILURE;
+    }
+
+    _initCRC();
+    memset( &pool, 0, sizeof(pool) );
+#ifdef XSLI_METRICS
+    _startMetrics();
+#endif
+
+#ifdef XSLI_DAEMON
+    if ( server.path != (const char *)0 )
+    {
+      code = serveSLI( paths, count );
+      free( (void *)paths );
+#ifdef XSLI_METRICS
+      _stopMetrics();
+#endif
+#ifdef XSLI_TRACE
+      if ( (trace.path != (const char *)0) && (_putTrace() != EXIT_SUCCESS) )
+      {
+        code = EXIT_FAILURE;
+      }
+#endif
+      return code;
+    }
+#endif
+
+    if ( options.listMode == LIST_CSV )
+    {
+      printf( "rom,name,offset,format,raw,decoded,ratio%s\n",
+              ((options.checksum != 0) ? ",crc32" : "") );
+    }
+
+#ifdef XSLI_METRICS
+    __atomic_store_n( &metrics.romsQueued, count, __ATOMIC_RELAXED );
+#endif
+
+    if (    (analytics.path != (const char *)0)
+         && ((analytics.JSON = fopen( analytics.path, "w" )) == (FILE *)0) )
+    {
+      fprintf( STATUS, "\n>>> Unable to create the statistics file!\n\n" );
+      code = EXIT_FAILURE;
+      count = 0;
+    }
+
+    if ( options.unpack != 0 )
+    {
+      code  = unpackSLI( paths, count, unpackDest );
+      count = 0;
+    }
+
+    if ( options.diff != 0 )
+    {
+      code  = diffSLI( paths[0], paths[1] );
+      count = 0;
+    }
+
+#ifdef XSLI_WATCH
+    if ( options.watch != 0 )
+    {
+      code = watchSLI();
+    }
+#endif
+
+    if (    (similarity.path != (const char *)0)
+         && (_openIndex( count != 0 ) != EXIT_SUCCESS) )
+    {
+      _closeIndex();
+      code  = EXIT_FAILURE;
+      count = 0;
+    }
+
+    while ( i < count )
+    {
+      if ( count > 1 )
+      {
+        fprintf( STATUS, "# ROM: \"%s\"\n", paths[i] );
+      }
+
+      if ( processROM( paths[i], &pool ) != EXIT_SUCCESS )
+      {
+        METER_ADD( failures, 1 );
+        code = EXIT_FAILURE;
+      }
+      else
+      {
+        METER_ADD( roms, 1 );
+      }
+
+      ++i;
+#ifdef XSLI_METRICS
+      __atomic_store_n( &metrics.romsQueued, count - i, __ATOMIC_RELAXED );
+#endif
+    }
+
+#ifdef XSLI_METRICS
+    _stopMetrics();
+#endif
+
+    if ( (analytics.JSON != (FILE *)0) && (fclose( analytics.JSON ) != 0) )
+    {
+      fprintf( STATUS, "\n>>> Unable to write the statistics file!\n\n" );
+      code = EXIT_FAILURE;
+    }
+
+    if ( similarity.INDEX != (FILE *)0 )
+    {
+      if (    (similarity.query != (const char *)0)
+           && (findSLI( similarity.query ) != EXIT_SUCCESS) )
+      {
+        code = EXIT_FAILURE;
+      }
+
+      if ( (_closeIndex() != EXIT_SUCCESS) || (similarity.isFailed != 0) )
+      {
+        code = EXIT_FAILURE;
+      }
+    }
+
+    free( (void *)paths );
+    paths = (const char **)0;
+    _poolFree( &pool );
+    fprintf( STATUS, "# Buffers: %u requested, %u allocated "
+                     "[%lu KiB total, %u KiB peak]\n",
+                     pool.requested, pool.allocated,
+                     (unsigned long)(pool.total >> 10), pool.peak >> 10 );
+
+    if ( filter.offsets != (u32 *)0 )
+    {
+      free( filter.offsets );
+      filter.offsets = (u32 *)0;
+    }
+
+#ifdef XSLI_TRACE
+    if ( (trace.path != (const char *)0) && (_putTrace() != EXIT_SUCCESS) )
+    {
+      code = EXIT_FAILURE;
+    }
+#endif
+
+    fprintf( STATUS, "# %u seconds elapsed.\n",
+                      (u32)(clock() / CLOCKS_PER_SEC) );
+    return code;
+  }
+}
+
+
+
+static void _usage( void )
+{
+  printf( "\n## SLI Extractor [Nintendo 64] ##\n"
+          ">> WGTDS [2021/10/30]\n\n" );
+  printf( "Usage: xsli [options] [ROMfile ...]\n\n"
+          "  -d    :   Decode SLI data into new files.\n"
+          "  -g    :   Use internal game name for files.\n"
+          "  -o    :   Write Big-Endian ROM.\n"
+          "  -k    :   Fix its header's checksums, if they're wrong.\n" );
+  printf( "  -l[F] :   List SLI data without writing any files.\n"
+          "            [F: \"c\" for CSV, \"j\" for JSON Lines, else text]\n"
+          "  -c    :   Include a CRC32 of each block in listings.\n"
+          "  -e[P] :   Write framed blocks to stdout instead of files.\n"
+          "            [P: \"d\" for decoded data, \"b\" for both,\n"
+          "             else raw blocks]\n" );
+  printf( "  --verify: Decode every top-level block with bounds checks,\n"
+          "            printing the CRC32 of each instead of any files.\n" );
+  printf( "  --unpack[=P]: Decode files that are each one block, as\n"
+          "            \".szs\" files are, without scanning them; to P,\n"
+          "            a directory if there are several, or \"-\" for\n"
+          "            stdout, else beside each file.\n" );
+  printf( "  --diff:   Compare the blocks of two ROMs as assets, by\n"
+          "            their data, listing those moved, recoded,\n"
+          "            modified, removed or added.\n" );
+  printf( "  --carve[=N[,D]]: Look for Yaz0 streams without a header as\n"
+          "            well, taking those with N bits of evidence or\n"
+          "            more [40] from chunks of D bits per byte [4.0].\n" );
+  printf( "  -hP   :   Add the hashes of every block decoded to the\n"
+          "            index P, skipping ROMs indexed unchanged.\n"
+          "  --find=X: Look up the decoded file X, or the CRC32 X, in\n"
+          "            the index of \"-h\", for the ROMs holding it and\n"
+          "            blocks much like it, after any ROMs given.\n" );
+  printf( "  -fF   :   Only extract the formats F [MIO0,Yay0,Yaz0,CMPR,\n"
+          "            Yaz1,LZ10,LZ11]; LZ10/LZ11 are only scanned for\n"
+          "            when named.\n"
+          "  -aS-E :   Only scan ROM offsets from S up to, but not E.\n"
+          "  -pO   :   Only check the ROM offsets O [O,O,...].\n"
+          "  -bL-H :   Only extract blocks of L to H bytes in length.\n"
+          "  -sL-H :   Only extract blocks that decode to L to H bytes.\n"
+          "            [Filters take lists split by \",\"; L, H and E may\n"
+          "             be left out, and offsets may be in hexadecimal]\n" );
+  printf( "  -r[N] :   Recursively scan decoded SLI data, N levels deep.\n"
+          "            [Default: %u, Maximum: %u]\n"
+          "  -i    :   Print a map of each ROM's padding and low/high\n"
+          "            entropy data, by 4 KiB chunk.\n"
+          "  -zP   :   Write statistics of how blocks were encoded to P,\n"
+          "            a line for each ROM [JSON].\n"
+          "  -wF   :   Write MIO0/Yay0/Yaz0 blocks in the format F\n"
+          "            [MIO0, Yay0 or Yaz0] instead, as files.\n"
+          "  -v    :   Enable verbose messages.\n",
+          DEPTH_DEF, DEPTH_MAX );
+#ifdef XSLI_METRICS
+  printf( "  -x[P] :   Show progress on a terminal, and write metrics to P\n"
+          "            every second [Prometheus text format].\n" );
+#endif
+#ifdef XSLI_TRACE
+  printf( "  -tP   :   Write a timeline of the run to P [Chrome trace].\n" );
+#endif
+#ifdef XSLI_DAEMON
+  printf( "  -uP   :   Serve requests on the Unix domain socket P,\n"
+          "            taking any ROMs given as ones to cache up front.\n"
+          "  -mN   :   Cache up to N MiB of ROMs while serving.\n"
+          "            [Default: %u]\n",
+          SRV_CACHEDEF );
+#endif
+#ifdef XSLI_WATCH
+  printf( "  --watch=D: Process each ROM written to the directory D as\n"
+          "            soon as it is complete, until interrupted, naming\n"
+          "            blocks after their ROM; those processed are\n"
+          "            recorded in D/%s.\n",
+          WATCH_RECORD );
+#endif
+#ifdef XSLI_THREADS
+  printf( "  -jN   :   Use N worker threads [-u, --verify, and decoding\n"
+          "            Yay0/Yaz0 blocks of 4 MiB or more].\n"
+          "            [Default: Online CPUs, Maximum: %u]\n",
+          THREADS_MAX );
+#endif
+}
+
+
+
+static int _closeROM( FILE *ROM, const int code )
+{
+  fclose( ROM );
+  return code;
+}
+
+
+
+static void _getPath( char *cdirROM )
+{
+  register int i = 0;
+
+  while ( cdirROM[i] != '\0' )
+  {
+    ++i;
+  }
+
+  while ( (i >= 0) && (cdirROM[i] != '\\') && (cdirROM[i] != '/') )
+  {
+    cdirROM[i--] = '\0';
+  }
+
+  return;
+}
+
+
+
+static const char **_processArgs( const int argc, char *argv[], u32 *count )
+{
+  const char **paths;
+  int c;
+  int i = 1;
+
+  statusFile = stdout;
+  *count = 0;
+
+  if ( (paths = (const char **)malloc( sizeof(char *) * argc )) == 0 )
+  {
+    fprintf( STATUS,
+             "\n>>> Unable to allocate work RAM for the file paths!\n\n" );
+    goto err;
+  }
+
+  options.toDecode    = 0;
+  options.useGameName = 0;
+  options.writeROM    = 0;
+  options.fixBoot     = 0;
+  options.carve       = 0;
+  options.verbose     = 0;
+  options.maxDepth    = 0;
+  options.listMode    = 0;
+  options.checksum    = 0;
+  options.emitMode    = 0;
+  options.verify      = 0;
+  options.showRegions = 0;
+
+  filter.formats      = FMT_ALL;
+  filter.countRanges  = 0;
+  filter.countOffsets = 0;
+  filter.offsets      = (u32 *)0;
+  filter.raw[0]       = 0;
+  filter.raw[1]       = 0xFFFFFFFFU;
+  filter.decoded[0]   = 0;
+  filter.decoded[1]   = 0xFFFFFFFFU;
+  filter.isWindowed   = 0;
+  filter.isActive     = 0;
+
+#ifdef XSLI_THREADS
+  {
+    long cpus = sysconf( _SC_NPROCESSORS_ONLN );
+
+    threads = (cpus < 1) ? 1U :
+              (cpus > THREADS_MAX) ? THREADS_MAX : (u32)cpus;
+  }
+#endif
+
+#ifdef XSLI_DAEMON
+  server.path       = (const char *)0;
+  server.cacheLimit = (u32)SRV_CACHEDEF << 20;
+#endif
+
+  while ( i < argc )
+  {
+    if ( strcmp( argv[i], "--verify" ) == 0 )
+    {
+      options.verify = 1;
+    }
+    else if ( strncmp( argv[i], "--unpack", 8 ) == 0 )
+    {
+      if (    (argv[i][8] != '\0')
+           && ((argv[i][8] != '=') || (argv[i][9] == '\0')) )
+      {
+        fprintf( STATUS, "\n>>> Unrecognized Option: \"%s\"\n\n", argv[i] );
+        goto err;
+      }
+
+      options.unpack = 1;
+      unpackDest = (argv[i][8] == '=') ? &argv[i][9] : (const char *)0;
+    }
+#ifdef XSLI_WATCH
+    else if ( strncmp( argv[i], "--watch=", 8 ) == 0 )
+    {
+      if ( argv[i][8] == '\0' )
+      {
+        fprintf( STATUS, "\n>>> No directory given to \"--watch\"!\n\n" );
+        goto err;
+      }
+
+      options.watch = 1;
+      watch.path    = &argv[i][8];
+    }
+#endif
+    else if ( strcmp( argv[i], "--diff" ) == 0 )
+    {
+      options.diff = 1;
+    }
+    else if ( strncmp( argv[i], "--carve", 7 ) == 0 )
+    {
+      if ( argv[i][7] == '=' )
+      {
+        char *end;
+
+        carving.bits = (u32)strtoul( &argv[i][8], &end, 10 );
+
+        if ( *end == ',' )
+        {
+          carving.density = strtod( end + 1, &end );
+        }
+
+        if (    (*end != '\0') || (end == &argv[i][8])
+             || (carving.bits == 0) || (carving.bits > 4096U)
+             || (carving.density < 0.0) || (carving.density > 8.0) )
+        {
+          fprintf( STATUS, "\n>>> Invalid thresholds for \"--carve\": "
+                           "\"%s\"\n\n", &argv[i][8] );
+          goto err;
+        }
+      }
+      else if ( argv[i][7] != '\0' )
+      {
+        fprintf( STATUS, "\n>>> Unrecognized Option: \"%s\"\n\n", argv[i] );
+        goto err;
+      }
+
+      options.carve = 1;
+    }
+    else if ( strncmp( argv[i], "--find=", 7 ) == 0 )
+    {
+      if ( argv[i][7] == '\0' )
+      {
+        fprintf( STATUS, "\n>>> Nothing given to \"--find\"!\n\n" );
+        goto err;
+      }
+
+      similarity.query = &argv[i][7];
+    }
+    else if ( argv[i][0] == '-' )
+    {
+      switch ( c = toupper( argv[i][1] ) )
+      {
+        case 'A':
+        case 'B':
+        case 'F':
+        case 'P':
+        case 'S':
+          if ( _parseFilter( c, &argv[i][2] ) != 0 )
+          {
+            fprintf( STATUS, "\n>>> Invalid Filter: \"%s\"\n\n", argv[i] );
+            goto err;
+          }
+
+          break;
+        case 'C':
+          options.checksum = 1;
+          break;
+        case 'D':
+          options.toDecode = 1;
+          break;
+        case 'E':
+          switch ( toupper( argv[i][2] ) )
+          {
+            case 'B':
+              options.emitMode = EMIT_BOTH;
+              break;
+            case 'D':
+              options.emitMode = EMIT_DECODED;
+              break;
+            default:
+              options.emitMode = EMIT_RAW;
+              break;
+          }
+
+          break;
+        case 'G':
+          options.useGameName = 1;
+          break;
+        case 'I':
+          options.showRegions = 1;
+          break;
+        case 'W':
+          {
+            static const char *names[4] = { "", "MIO0", "YAY0", "YAZ0" };
+            const char *text = &argv[i][2];
+            u32 j = CODE_MIO;
+
+            while ( j <= CODE_YAZ )
+            {
+              u32 k = 0;
+
+              while (    (k < 4U)
+                      && (toupper( (unsigned char)text[k] ) == names[j][k]) )
+              {
+                ++k;
+              }
+
+              if ( (k == 4U) && (text[4] == '\0') )
+              {
+                break;
+              }
+
+              ++j;
+            }
+
+            if ( j > CODE_YAZ )
+            {
+              fprintf( STATUS, "\n>>> Invalid Format: \"%s\"\n\n", argv[i] );
+              goto err;
+            }
+
+            options.transcode = j;
+          }
+
+          break;
+        case 'Z':
+          if ( argv[i][2] == '\0' )
+          {
+            fprintf( STATUS, "\n>>> No statistics file given to \"-z\"!\n\n" );
+            goto err;
+          }
+
+          analytics.path = &argv[i][2];
+          break;
+        case 'H':
+          if ( argv[i][2] == '\0' )
+          {
+            fprintf( STATUS, "\n>>> No index file given to \"-h\"!\n\n" );
+            goto err;
+          }
+
+          similarity.path = &argv[i][2];
+          break;
+#ifdef XSLI_THREADS
+        case 'J':
+          {
+            unsigned long count = strtoul( &argv[i][2], (char **)0, 10 );
+
+            threads = (count < 1) ? 1U :
+                      (count > THREADS_MAX) ? THREADS_MAX : (u32)count;
+          }
+
+          break;
+#endif
+#ifdef XSLI_DAEMON
+        case 'M':
+          {
+            unsigned long limit = strtoul( &argv[i][2], (char **)0, 10 );
+
+            server.cacheLimit = (limit > 4095UL) ? 0xFFFFFFFFU :
+                                ((u32)limit << 20);
+          }
+
+          break;
+        case 'U':
+          if ( argv[i][2] == '\0' )
+          {
+            fprintf( STATUS, "\n>>> No socket path given to \"-u\"!\n\n" );
+            goto err;
+          }
+
+          server.path = &argv[i][2];
+          break;
+#endif
+        case 'L':
+          switch ( toupper( argv[i][2] ) )
+          {
+            case 'C':
+              options.listMode = LIST_CSV;
+              break;
+            case 'J':
+              options.listMode = LIST_JSON;
+              break;
+            default:
+              options.listMode = LIST_TEXT;
+              break;
+          }
+
+          break;
+        case 'O':
+          options.writeROM = 1;
+          break;
+        case 'K':
+          options.fixBoot = 1;
+          break;
+#ifdef XSLI_METRICS
+        case 'X':
+          metrics.isEnabled = 1;
+          metrics.path = (argv[i][2] != '\0') ? &argv[i][2] : (const char *)0;
+          break;
+#endif
+#ifdef XSLI_TRACE
+        case 'T':
+          if ( argv[i][2] == '\0' )
+          {
+            fprintf( STATUS, "\n>>> No trace file given to \"-t\"!\n\n" );
+            goto err;
+          }
+
+          trace.path = &argv[i][2];
+          clock_gettime( CLOCK_MONOTONIC, &trace.start );
+          break;
+#endif
+        case 'R':
+          if ( argv[i][2] != '\0' )
+          {
+            unsigned long depth = strtoul( &argv[i][2], (char **)0, 10 );
+
+            options.maxDepth = (depth < DEPTH_MAX) ? depth : DEPTH_MAX;
+          }
+          else
+          {
+            options.maxDepth = DEPTH_DEF;
+          }
+
+          break;
+        case 'V':
+          options.verbose = 1;
+          break;
+        default:
+          fprintf( STATUS, "\n>>> Unrecognized Option: \"%c\"\n\n", (char)c );
+          break;
+      }
+    }
+    else
+    {
+      if ( strlen( argv[i] ) >= PPATH_MAX )
+      {
+        fprintf( STATUS, "\n>>> Path length is too long!\n\n" );
+        goto err;
+      }
+      else
+      {
+        paths[(*count)++] = argv[i];
+      }
+    }
+
+    ++i;
+  }
+
+#ifdef XSLI_DAEMON
+  if (    (*count == 0) && (server.path == (const char *)0)
+       && (similarity.query == (const char *)0) && (options.watch == 0) )
+#else
+  if (    (*count == 0) && (similarity.query == (const char *)0)
+       && (options.watch == 0) )
+#endif
+  {
+    fprintf( STATUS, "\n>>> No ROM file to process!\n\n" );
+    goto usg;
+  }
+
+  if ( filter.countOffsets > 1 )
+  {
+    qsort( filter.offsets, filter.countOffsets, sizeof(u32), _compareU32 );
+  }
+
+  /*-----------------------------------------------------------
+  Formats left out by "-f" are still looked for, to be counted
+  as filtered; those found by a leading byte alone aren't.
+  -----------------------------------------------------------*/
+  _buildLeads( FMT_ALL | filter.formats );
+  filter.isWindowed = (filter.countRanges != 0) || (filter.countOffsets != 0);
+  filter.isActive   =    (filter.isWindowed != 0)
+                      || (filter.formats != FMT_ALL)
+                      || (filter.raw[0] != 0)
+                      || (filter.raw[1] != 0xFFFFFFFFU)
+                      || (filter.decoded[0] != 0)
+                      || (filter.decoded[1] != 0xFFFFFFFFU);
+
+  if ( (options.emitMode != 0) && (options.listMode != 0) )
+  {
+    fprintf( STATUS, "\n>>> \"-e\" and \"-l\" can't be used together!\n\n" );
+    goto err;
+  }
+
+#ifdef XSLI_DAEMON
+  if (    (server.path != (const char *)0)
+       && (analytics.path != (const char *)0) )
+  {
+    fprintf( STATUS, "\n>>> \"-z\" can't be used with \"-u\"!\n\n" );
+    goto err;
+  }
+#endif
+
+  if ( (options.verify != 0) && ((options.emitMode | options.listMode) != 0) )
+  {
+    fprintf( STATUS,
+             "\n>>> \"--verify\" can't be used with \"-e\" or \"-l\"!\n\n" );
+    goto err;
+  }
+
+  if (    (options.unpack != 0)
+       && ((options.emitMode | options.listMode | options.verify) != 0) )
+  {
+    fprintf( STATUS, "\n>>> \"--unpack\" can't be used with \"-e\", "
+                     "\"-l\" or \"--verify\"!\n\n" );
+    goto err;
+  }
+
+  if (    (options.diff != 0)
+       && (    (*count != 2U)
+            || ((options.emitMode | options.listMode) != 0)
+            || ((options.verify | options.unpack) != 0)
+            || (similarity.path != (const char *)0)
+#ifdef XSLI_DAEMON
+            || (server.path != (const char *)0)
+#endif
+          ) )
+  {
+    fprintf( STATUS, "\n>>> \"--diff\" takes two ROMs, and none of "
+                     "\"-e\", \"-l\", \"-h\", \"-u\",\n"
+                     "    \"--verify\" or \"--unpack\"!\n\n" );
+    goto err;
+  }
+
+  if (    (options.watch != 0)
+       && (    (*count != 0)
+            || ((options.emitMode | options.listMode) != 0)
+            || ((options.verify | options.unpack | options.diff) != 0)
+            || (analytics.path != (const char *)0)
+            || (similarity.path != (const char *)0)
+#ifdef XSLI_DAEMON
+            || (server.path != (const char *)0)
+#endif
+          ) )
+  {
+    fprintf( STATUS, "\n>>> \"--watch\" takes no ROMs, and none of "
+                     "\"-e\", \"-l\", \"-z\", \"-h\",\n    \"-u\", "
+                     "\"--verify\", \"--unpack\" or \"--diff\"!\n\n" );
+    goto err;
+  }
+
+  if (    (options.carve != 0)
+       && (    ((options.verify | options.unpack | options.diff) != 0)
+#ifdef XSLI_DAEMON
+            || (server.path != (const char *)0)
+#endif
+          ) )
+  {
+    fprintf( STATUS, "\n>>> \"--carve\" can't be used with \"-u\", "
+                     "\"--verify\", \"--unpack\" or \"--diff\"!\n\n" );
+    goto err;
+  }
+
+  if ( (options.fixBoot != 0) && (options.writeROM == 0) )
+  {
+    fprintf( STATUS, "\n>>> \"-k\" needs a ROM to fix from \"-o\"!\n\n" );
+    goto err;
+  }
+
+  if (    (similarity.query != (const char *)0)
+       && (similarity.path == (const char *)0) )
+  {
+    fprintf( STATUS, "\n>>> \"--find\" needs an index from \"-h\"!\n\n" );
+    goto err;
+  }
+
+  if (    (similarity.path != (const char *)0)
+#ifdef XSLI_DAEMON
+       && (    (server.path != (const char *)0)
+            || ((options.verify | options.unpack) != 0) ) )
+#else
+       && ((options.verify | options.unpack) != 0) )
+#endif
+  {
+    fprintf( STATUS, "\n>>> \"-h\" can't be used with \"--verify\", "
+                     "\"--unpack\" or \"-u\"!\n\n" );
+    goto err;
+  }
+
+  /*------------------------------------------------------------
+  Listings in CSV or JSON own the standard output, so that they
+  can be redirected or piped; everything else goes to stderr.
+  The same goes for frames, which are buffered in large writes
+  where they aren't gathered by "writev" already.
+  ------------------------------------------------------------*/
+  if (    (options.listMode == LIST_CSV) || (options.listMode == LIST_JSON)
+       || (options.emitMode != 0) || (options.diff != 0)
+       || (    (unpackDest != (const char *)0)
+            && (strcmp( unpackDest, "-" ) == 0) ) )
+  {
+    statusFile = stderr;
+  }
+
+#ifndef XSLI_GATHER
+  if ( options.emitMode != 0 )
+  {
+    setvbuf( stdout, (char *)0, _IOFBF, 0x100000 );
+  }
+#endif
+
+  if ( options.listMode != 0 )
+  {
+    fprintf( STATUS, "<LISTING:        %s>\n",
+                     ((options.listMode == LIST_CSV)  ? "CSV"  :
+                      (options.listMode == LIST_JSON) ? "JSON" : "TEXT") );
+  }
+
+  if ( options.checksum != 0 )
+  {
+    fprintf( STATUS, "<CHECKSUMS:      ENABLED>\n" );
+  }
+
+  if ( options.emitMode != 0 )
+  {
+    fprintf( STATUS, "<FRAMES:         %s>\n",
+                     ((options.emitMode == EMIT_BOTH)    ? "RAW+DECODED" :
+                      (options.emitMode == EMIT_DECODED) ? "DECODED"     :
+                                                           "RAW") );
+  }
+
+  if ( options.verify != 0 )
+  {
+    fprintf( STATUS, "<VERIFYING:      ENABLED>\n" );
+  }
+
+  if ( options.unpack != 0 )
+  {
+    fprintf( STATUS, "<UNPACKING:      %s>\n",
+                     ((unpackDest != (const char *)0) ? unpackDest :
+                                                        "ENABLED") );
+  }
+
+  if ( analytics.path != (const char *)0 )
+  {
+    fprintf( STATUS, "<STATISTICS:     ENABLED>\n" );
+  }
+
+  if ( similarity.path != (const char *)0 )
+  {
+    fprintf( STATUS, "<INDEX:          %s>\n", similarity.path );
+  }
+
+  if ( options.diff != 0 )
+  {
+    fprintf( STATUS, "<COMPARING:      ENABLED>\n" );
+  }
+
+  if ( options.carve != 0 )
+  {
+    fprintf( STATUS, "<CARVING:        %u BITS, %.1f>\n",
+                     carving.bits, carving.density );
+  }
+
+#ifdef XSLI_WATCH
+  if ( options.watch != 0 )
+  {
+    fprintf( STATUS, "<WATCHING:       %s>\n", watch.path );
+  }
+#endif
+
+  if ( similarity.query != (const char *)0 )
+  {
+    fprintf( STATUS, "<FINDING:        %s>\n", similarity.query );
+  }
+
+  if ( options.transcode != 0 )
+  {
+    fprintf( STATUS, "<TRANSCODING:    %s>\n",
+                     ((options.transcode == CODE_MIO) ? "MIO0" :
+                      (options.transcode == CODE_YAY) ? "Yay0" : "Yaz0") );
+  }
+
+  if ( options.toDecode != 0 )
+  {
+    fprintf( STATUS, "<DECODING:       ENABLED>\n" );
+  }
+
+  if ( options.useGameName != 0 )
+  {
+    fprintf( STATUS, "<USE-GAME-NAME:  ENABLED>\n" );
+  }
+
+  if ( options.writeROM != 0 )
+  {
+    fprintf( STATUS, "<WRITE-BE-ROM:   ENABLED>\n" );
+  }
+
+  if ( options.fixBoot != 0 )
+  {
+    fprintf( STATUS, "<FIX-CHECKSUMS:  ENABLED>\n" );
+  }
+
+  if ( options.maxDepth != 0 )
+  {
+    fprintf( STATUS, "<RECURSIVE-SCAN: %2u LEVELS>\n",
+                     (unsigned)options.maxDepth );
+  }
+
+  if ( filter.isActive != 0 )
+  {
+    fprintf( STATUS, "<FILTERS:        ENABLED>\n" );
+  }
+
+#ifdef XSLI_DAEMON
+  if ( server.path != (const char *)0 )
+  {
+    fprintf( STATUS, "<SERVING:        %u MiB CACHE>\n",
+                     server.cacheLimit >> 20 );
+  }
+#endif
+
+#ifdef XSLI_TRACE
+  if ( trace.path != (const char *)0 )
+  {
+    fprintf( STATUS, "<TRACING:        ENABLED>\n" );
+  }
+#endif
+
+#ifdef XSLI_METRICS
+  if ( metrics.isEnabled != 0 )
+  {
+    fprintf( STATUS, "<METRICS:        %s>\n",
+                     ((metrics.path != (const char *)0) ? "ENABLED" :
+                                                          "PROGRESS ONLY") );
+  }
+#endif
+
+  if ( options.verbose != 0 )
+  {
+    fprintf( STATUS, "<VERBOSITY:      ENABLED>\n" );
+  }
+
+  return paths;
+
+usg:
+
+  _usage();
+
+err:
+
+  if ( paths != (const char **)0 )
+  {
+    free( (void *)paths );
+  }
+
+  return paths = (const char **)0;
+}
+
+
+
+static int _compareU32( const void *a, const void *b )
+{
+  return (*(const u32 *)a > *(const u32 *)b) -
+         (*(const u32 *)a < *(const u32 *)b);
+}
+
+
+
+/*----------------------------------------------------------------
+Parses "[A][-[B]]" up to a comma or the end of "text", where either
+bound may be left out. Returns a pointer past what was parsed, or
+NULL if it isn't a valid span.
+----------------------------------------------------------------*/
+static const char *_parseSpan( const char *text, u32 span[2] )
+{
+  char *end = (char *)text;
 
-    if ( (path = _processArgs( argc, argv )) == (char *)0 )
-    {
-      return EXIT_FAILURE;
-    }
+  span[0] = 0;
+  span[1] = 0xFFFFFFFFU;
+
+  if ( isdigit( (unsigned char)*text ) )
+  {
+    span[0] = (u32)strtoul( text, &end, 0 );
+  }
 
-    strcpy( pathROM, path );
-    strcpy( cdirROM, path );
+  if ( *end == '-' )
+  {
+    text = end + 1;
 
-    if ( (ROM = fopen( pathROM, "rb" )) == (FILE *)0 )
+    if ( isdigit( (unsigned char)*text ) )
     {
-      free( path );
-      path = (char *)0;
-      printf( "\n>>> Unable to open:\n>>> \"%s\"\n\n", pathROM );
-      return EXIT_FAILURE;
+      span[1] = (u32)strtoul( text, &end, 0 );
     }
     else
     {
-      u8 *srcbuf = (u8 *)0;
-      u32 lengthROM;
+      end = (char *)text;
+    }
+  }
+
+  if ( ((*end != ',') && (*end != '\0')) || (span[0] > span[1]) )
+  {
+    return (const char *)0;
+  }
+
+  return (*end == ',') ? (end + 1) : end;
+}
+
 
-      fseek( ROM, 0L, SEEK_END );
-      lengthROM = (u32)ftell( ROM );
 
-      if (    (lengthROM == (u32)EOF)
-           || (lengthROM >= 0x3FFFFFFF)
-           || (lengthROM == 0) )
+/*------------------------------------------------------------------
+Adds the filter given by the option letter "c" and its argument,
+each of which may be given more than once:
+  -a : Offset ranges,      "-a0x1000-0x8000,0x20000-0x40000"
+  -b : Block length,       "-b0x100-0x10000"
+  -f : Formats,            "-fyaz0,yay0"
+  -p : Offsets,            "-p0x1400,0x39600"
+  -s : Decoded size,       "-s0x10000-"
+Returns non-zero on an invalid argument.
+------------------------------------------------------------------*/
+static int _parseFilter( const int c, const char *text )
+{
+  u32 span[2];
+
+  if ( *text == '\0' )
+  {
+    return 1;
+  }
+
+  switch ( c )
+  {
+    case 'B':
+    case 'S':
+      if ( (text = _parseSpan( text, span )) == (const char *)0 )
       {
-        printf( "\n>>> Unsupported ROM file size!\n\n" );
-        return _closeROM( ROM, 1 );
+        return 1;
+      }
+
+      if ( c == 'B' )
+      {
+        filter.raw[0] = span[0];
+        filter.raw[1] = span[1];
       }
       else
       {
-        if ( (srcbuf = (u8 *)calloc( lengthROM, sizeof(u8) )) == (u8 *)0 )
-        {
-          printf( "\n>>> Error allocating RAM for ROM buffer!\n\n" );
-          return _closeROM( ROM, 1 );
-        }
-        else
+        filter.decoded[0] = span[0];
+        filter.decoded[1] = span[1];
+      }
+
+      return *text != '\0';
+    case 'F':
+      if ( filter.formats == FMT_ALL )
+      {
+        filter.formats = 0;
+      }
+
+      while ( *text != '\0' )
+      {
+        u32 j = 0;
+
+        while ( j < FORMAT_SLOTS )
         {
-          rewind( ROM );
+          u32 k = 0;
 
-          if ( (u32)fread( srcbuf, sizeof(u8), lengthROM, ROM ) != lengthROM )
+          while (    (k < 4U)
+                  && (   toupper( (unsigned char)text[k] )
+                      == toupper( (unsigned char)formats[j].name[k] ) ) )
           {
-            printf( "\n>>> Error reading from ROM file into buffer!\n\n" );
-            return _closeROM( ROM, 1 );
+            ++k;
           }
-          else
+
+          if ( (k == 4U) && ((text[4] == ',') || (text[4] == '\0')) )
           {
-            u32 magic  = _swap32( *(u32 *)srcbuf );
-            u32 fourCC = 0;
+            break;
+          }
 
-            fclose( ROM );
-            _getPath( cdirROM );
-            fourCC = (((magic == 0x80371240U) << 3) |
-                      ((magic == 0x40123780U) << 2) |
-                      ((magic == 0x37804012U) << 1) |
-                       (magic == 0x12408037U));
+          ++j;
+        }
 
-            if ( fourCC == 0 )
-            {
-              printf( "# Not an N64 ROM!\n"
-                      "# Will attempt to scan for Big-Endian SLI data.\n" );
+        if ( j == FORMAT_SLOTS )
+        {
+          return 1;
+        }
 
-              if ( options.useGameName != 0 )
-              {
-                options.useGameName = 0;
-                printf( "<USE-GAME-NAME:  DISABLED>\n" );
-              }
+        filter.formats |= formats[j].bit;
+        text += (text[4] == ',') ? 5 : 4;
+      }
 
-              if ( options.writeROM != 0 )
-              {
-                options.writeROM = 0;
-                printf( "<WRITE-BE-ROM:   DISABLED>\n" );
-              }
-            }
-            else
-            {
-              if ( (fourCC & 8U) == 0 )
-              {
-                if ( (lengthROM & 3) != 0 )
-                {
-                  printf( "# ROM isn't 32-bit aligned...\n"
-                          "# Aligning.\n" );
-
-                  while ( (lengthROM & 3) != 0 )
-                  {
-                    ++lengthROM;
-                  }
-
-                  if (    (srcbuf = (u8 *)realloc( srcbuf, lengthROM ))
-                       == (u8 *)0 )
-                  {
-                    printf( "\n>>> Unable to extend for alignment!\n\n" );
-                    return EXIT_FAILURE;
-                  }
-                }
+      return 0;
+    default:
+      break;
+  }
 
-                printf( "# Found Nintendo 64 ROM Magic!\n"
-                        "# Ordering bytes to Big-Endian.\n" );
-                _orderBytes( srcbuf, fourCC, lengthROM );
+  while ( *text != '\0' )
+  {
+    if ( c == 'A' )
+    {
+      if (    (filter.countRanges == RANGES_MAX)
+           || ((text = _parseSpan( text, span )) == (const char *)0) )
+      {
+        return 1;
+      }
 
-                if ( options.writeROM != 0 )
-                {
-                  if ( _writeROM( srcbuf, lengthROM, pathROM ) != 0 )
-                  {
-                    return EXIT_FAILURE;
-                  }
-                }
-              }
-            }
+      filter.ranges[filter.countRanges][0] = span[0];
+      filter.ranges[filter.countRanges][1] = span[1];
+      ++filter.countRanges;
+    }
+    else
+    {
+      char *end = (char *)text;
+      u32 *offsets;
 
-            scanSLI( srcbuf, lengthROM, fourCC, cdirROM );
+      if ( !isdigit( (unsigned char)*text ) )
+      {
+        return 1;
+      }
 
-            if ( srcbuf != (u8 *)0 )
-            {
-              free( srcbuf );
-              srcbuf = (u8 *)0;
-            }
+      offsets = (u32 *)realloc( filter.offsets,
+                                sizeof(u32) * (filter.countOffsets + 1U) );
 
-            printf( "# %u seconds elapsed.\n",
-                    (u32)(clock() / CLOCKS_PER_SEC) );
-            return EXIT_SUCCESS;
-          }
-        }
+      if ( offsets == (u32 *)0 )
+      {
+        return 1;
+      }
+
+      filter.offsets = offsets;
+      filter.offsets[filter.countOffsets++] = (u32)strtoul( text, &end, 0 );
+
+      if ( (*end != ',') && (*end != '\0') )
+      {
+        return 1;
       }
+
+      text = (*end == ',') ? (end + 1) : end;
     }
   }
+
+  return 0;
 }
 
 
 
-static void _usage( void )
+/*---------------------------------------------------------
+A word of the ROM, as loaded from memory, in the order that
+"_orderBytes" would leave it in memory; Big-Endian is kept.
+---------------------------------------------------------*/
+static u32 _orderWord( u32 word, const u32 fourCC )
 {
-  printf( "\n## SLI Extractor [Nintendo 64] ##\n"
-          ">> WGTDS [2021/10/30]\n\n" );
-  printf( "Usage: xsli [options] [ROMfile]\n\n"
-          "  -d    :   Decode SLI data into new files.\n"
-          "  -g    :   Use internal game name for files.\n"
-          "  -o    :   Write Big-Endian ROM.\n"
-          "  -v    :   Enable verbose messages.\n" );
-}
+  enum
+  {
+    ENDIAN_BS_LITTLE = 1,
+    ENDIAN_BS_BIG    = 2,
+    ENDIAN_LITTLE    = 4,
+    ENDIAN_BIG       = 8
+  };
 
+  /*---------------------------------------------------------
+  Recognized Byte Ordering:
+      0x80371240 [ABCD, Big-Endian][Native to the Nintendo64]
+      0x40123780 [DCBA, Little-Endian]
+      0x37804012 [BADC, Byte-Swapped Big-Endian]
 
+      Unrecognized Byte Ordering:
+      0x12408037 [CDAB, Byte-Swapped Little-Endian]
+  ---------------------------------------------------------*/
+  if ( fourCC == ENDIAN_BIG )
+  {
+    return word;
+  }
+  /*---------------------------------
+  For DCBA and arranging CDAB to BADC
+  ---------------------------------*/
+  if ( fourCC != ENDIAN_BS_BIG )
+  {
+    word = _swap32( word );
+  }
+  /*------
+  For BADC
+  ------*/
+  if ( fourCC != ENDIAN_LITTLE )
+  {
+    word = ((word & 0x00FF00FFU) << 8) | ((word >> 8) & 0x00FF00FFU);
+  }
 
-static int _closeROM( FILE *ROM, const int code )
-{
-  fclose( ROM );
-  return code;
+  return word;
 }
 
 
 
-static void _getPath( char *cdirROM )
+static void _orderBytes( u8 *srcbuf, const u32 fourCC, const u32 lengthROM )
 {
-  register int i = 0;
-
-  while ( cdirROM[i] != '\0' )
-  {
-    ++i;
-  }
+  register u32 i = 0;
 
-  while ( (cdirROM[i] != '\\') && (cdirROM[i] != '/') && (i >= 0) )
+  do
   {
-    cdirROM[i--] = '\0';
+    *(u32 *)&srcbuf[i] = _orderWord( *(u32 *)&srcbuf[i], fourCC );
+    i += 4;
   }
+  while ( i < lengthROM );
 
   return;
 }
 
 
 
-static char *_processArgs( const int argc, char *argv[] )
+/*---------------------------------------------------------------------
+The boot code checks CRC1 and CRC2, the words at 0x10 and 0x14 of the
+header, against a sum of the MiB of the ROM after it, seeded, and with
+a twist or two, as the CIC chip of the cartridge is made for. Which
+chip that is, is told apart by the CRC32 of the boot code itself.
+Words are summed as "_orderWord" puts them in order, so a ROM needn't
+be in Big-Endian order in memory first.
+---------------------------------------------------------------------*/
+#define BOOT_CODE   0x40U      /* Up to BOOT_START */
+#define BOOT_START  0x1000U
+#define BOOT_LENGTH 0x100000U
+
+struct cic
 {
-  char *pathROM;
-  int c;
-  int f = 0;
-  int i = 1;
+  u32 bootCRC;
+  u32 id;
+  u32 seed;
+};
+
+static const struct cic cics[] =
+{
+  { 0x6170A4A1U, 6101, 0xF8CA4DDCU },
+  { 0x90BB6CB5U, 6102, 0xF8CA4DDCU },
+  { 0x009E9EA3U, 7102, 0xF8CA4DDCU },
+  { 0x0B050EE0U, 6103, 0xA3886759U },
+  { 0x98BC2C86U, 6105, 0xDF26F436U },
+  { 0xACC8580AU, 6106, 0x1FEA617AU }
+};
+
+
+
+/*----------------------------------------------------------------
+Fills "boot" for an N64 ROM in the byte order "fourCC"; its "cic"
+is zero for a ROM too short to be summed, or of an unknown chip.
+----------------------------------------------------------------*/
+static void _sumBoot( const u8 *srcbuf, const u32 lengthROM,
+                      const u32 fourCC, struct boot *boot )
+{
+  const struct cic *cic = (const struct cic *)0;
+  register u32 t1, t2, t3, t4, t5, t6;
+  register u32 i;
+  u32 bootCRC;
 
-  if ( (pathROM = (char *)malloc( sizeof(char) * PPATH_MAX )) == (char *)0 )
+  boot->cic = 0;
+
+  if ( lengthROM < (BOOT_START + BOOT_LENGTH) )
   {
-    printf( "\n>>> Unable to allocate work RAM for the file path!\n\n" );
-    goto err;
+    return;
   }
 
-  options.toDecode    = 0;
-  options.useGameName = 0;
-  options.writeROM    = 0;
-  options.verbose     = 0;
+  bootCRC = _crc32( srcbuf, BOOT_CODE, BOOT_START - BOOT_CODE,
+                    _getSwizzle( fourCC ) );
 
-  while ( i < argc )
+  for ( i = 0; i < (sizeof(cics) / sizeof(cics[0])); ++i )
   {
-    if ( argv[i][0] == '-' )
+    if ( cics[i].bootCRC == bootCRC )
     {
-      switch ( c = toupper( argv[i][1] ) )
-      {
-        case 'D':
-          options.toDecode = 1;
-          printf( "<DECODING:       ENABLED>\n" );
-          break;
-        case 'G':
-          options.useGameName = 1;
-          printf( "<USE-GAME-NAME:  ENABLED>\n" );
-          break;
-        case 'O':
-          options.writeROM = 1;
-          printf( "<WRITE-BE-ROM:   ENABLED>\n" );
-          break;
-        case 'V':
-          options.verbose = 1;
-          printf( "<VERBOSITY:      ENABLED>\n" );
-          break;
-        default:
-          printf( "\n>>> Unrecognized Option: \"%c\"\n\n", (char)c );
-          break;
-      }
+      cic = &cics[i];
     }
-    else
+  }
+
+  if ( cic == (const struct cic *)0 )
+  {
+    return;
+  }
+
+  t1 = t2 = t3 = t4 = t5 = t6 = cic->seed;
+
+  for ( i = BOOT_START; i < (BOOT_START + BOOT_LENGTH); i += 4U )
+  {
+    u32 d = _swap32( _orderWord( *(const u32 *)&srcbuf[i], fourCC ) );
+    u32 r = ((d & 0x1FU) != 0) ?
+            ((d << (d & 0x1FU)) | (d >> (32U - (d & 0x1FU)))) : d;
+
+    if ( (t6 + d) < t6 )
     {
-      if ( f != 1 )
-      {
-        if ( strlen( argv[i] ) >= PPATH_MAX )
-        {
-          printf( "\n>>> Path length is too long!\n\n" );
-          goto err;
-        }
-        else
-        {
-          pathROM = argv[i];
-          f = 1;
-        }
-      }
-      else
-      {
-        printf( "\n>>> Erroneous arguments!\n\n" );
-        goto usg;
-      }
+      ++t4;
     }
 
-    ++i;
+    t6 += d;
+    t3 ^= d;
+    t5 += r;
+    t2 ^= (t2 > d) ? r : (t6 ^ d);
+
+    /*-----------------------------------------------------
+    The 6105 mixes in a word of its own boot code instead.
+    -----------------------------------------------------*/
+    if ( cic->id == 6105 )
+    {
+      t1 += _swap32( _orderWord( *(const u32 *)&srcbuf[0x750U + (i & 0xFFU)],
+                                 fourCC ) ) ^ d;
+    }
+    else
+    {
+      t1 += t5 ^ d;
+    }
   }
 
-  if ( f == 0 )
+  switch ( cic->id )
   {
-    printf( "\n>>> No ROM file to process!\n\n" );
-    goto usg;
+    case 6103:
+      boot->crcs[0] = (t6 ^ t4) + t3;
+      boot->crcs[1] = (t5 ^ t2) + t1;
+      break;
+    case 6106:
+      boot->crcs[0] = (t6 * t4) + t3;
+      boot->crcs[1] = (t5 * t2) + t1;
+      break;
+    default:
+      boot->crcs[0] = t6 ^ t4 ^ t3;
+      boot->crcs[1] = t5 ^ t2 ^ t1;
+      break;
   }
 
-  return pathROM;
-
-usg:
+  boot->header[0] = _swap32( _orderWord( *(const u32 *)&srcbuf[0x10U],
+                                         fourCC ) );
+  boot->header[1] = _swap32( _orderWord( *(const u32 *)&srcbuf[0x14U],
+                                         fourCC ) );
+  boot->cic = cic->id;
+  return;
+}
 
-  _usage();
 
-err:
 
-  if ( pathROM != (char *)0 )
+static void _putBoot( const struct boot *boot )
+{
+  if ( boot->cic == 0 )
   {
-    free( pathROM );
+    if ( options.verbose != 0 )
+    {
+      fprintf( STATUS, "# Checksums: Not checked [unknown CIC]\n" );
+    }
+  }
+  else if (    (boot->crcs[0] == boot->header[0])
+            && (boot->crcs[1] == boot->header[1]) )
+  {
+    fprintf( STATUS, "# Checksums: %08X %08X [CIC-NUS-%u]\n",
+                     boot->crcs[0], boot->crcs[1], boot->cic );
+  }
+  else
+  {
+    fprintf( STATUS, "# Checksums: %08X %08X [CIC-NUS-%u], "
+                     "but the header has %08X %08X!\n",
+                     boot->crcs[0], boot->crcs[1], boot->cic,
+                     boot->header[0], boot->header[1] );
   }
 
-  return pathROM = (char *)0;
+  return;
 }
 
 
 
-static void _orderBytes( u8 *srcbuf, const u32 fourCC, const u32 lengthROM )
+/*---------------------------------------------------------
+With "-k", puts the checksums of "boot" into the header of
+the Big-Endian ROM written for "pathROM", where they differ.
+---------------------------------------------------------*/
+static int _fixBoot( const char *pathROM, const struct boot *boot )
 {
-  enum
-  {
-    ENDIAN_BS_LITTLE = 1,
-    ENDIAN_BS_BIG    = 2,
-    ENDIAN_LITTLE    = 4,
-    ENDIAN_BIG       = 8
-  };
-  register u32 i = 0;
+  FILE *ROM;
+  char newPathROM[PPATH_MAX + 8];
+  u32 crcs[2];
 
-  do
+  if (    (options.fixBoot == 0) || (boot->cic == 0)
+       || (    (boot->crcs[0] == boot->header[0])
+            && (boot->crcs[1] == boot->header[1])) )
   {
-    /*---------------------------------------------------------
-    Recognized Byte Ordering:
-        0x80371240 [ABCD, Big-Endian][Native to the Nintendo64]
-        0x40123780 [DCBA, Little-Endian]
-        0x37804012 [BADC, Byte-Swapped Big-Endian]
+    return EXIT_SUCCESS;
+  }
 
-        Unrecognized Byte Ordering:
-        0x12408037 [CDAB, Byte-Swapped Little-Endian]
-    ---------------------------------------------------------*/
-    /*---------------------------------
-    For DCBA and arranging CDAB to BADC
-    ---------------------------------*/
-    if ( fourCC != ENDIAN_BS_BIG )
-    {
-      *(u32 *)&srcbuf[i] = _swap32( *(u32 *)&srcbuf[i] );
-    }
-    /*------
-    For BADC
-    ------*/
-    if ( fourCC != ENDIAN_LITTLE )
-    {
-      *(u16 *)&srcbuf[i    ] = _swap16( *(u16 *)&srcbuf[i    ] );
-      *(u16 *)&srcbuf[i + 2] = _swap16( *(u16 *)&srcbuf[i + 2] );
-    }
+  _getBSPath( pathROM, newPathROM );
+  crcs[0] = _swap32( boot->crcs[0] );
+  crcs[1] = _swap32( boot->crcs[1] );
 
-    i += 4;
+  if (    ((ROM = fopen( newPathROM, "r+b" )) == (FILE *)0)
+       || (fseek( ROM, 0x10L, SEEK_SET ) != 0)
+       || (fwrite( crcs, sizeof(u32), 2, ROM ) != 2)
+       || (fclose( ROM ) != 0) )
+  {
+    fprintf( STATUS, "\n>>> Unable to fix the Big-Endian ROM's header!\n\n" );
+    return EXIT_FAILURE;
   }
-  while ( i < lengthROM );
 
-  return;
+  fprintf( STATUS, "# Checksums fixed in the Big-Endian ROM.\n" );
+  return EXIT_SUCCESS;
 }
 
 
 
-static int _writeROM( const u8 *srcbuf, const u32 lengthROM,
-                      const char *pathROM )
+/*---------------------------------------------------------------------
+Each ordering that "_orderBytes" rearranges is a fixed permutation of
+the four bytes of a word, so a Big-Endian offset maps to its place in
+the buffer by an exclusive-or of its lowest two bits:
+    DCBA : 3, BADC : 1, CDAB : 2
+---------------------------------------------------------------------*/
+/*--------------------------------------------------------
+One bit per N64 byte ordering of the ROM's leading word:
+8 = Big-Endian, 4 = Little-Endian, 2 = Byte-Swapped, 1 =
+Word-Swapped; zero for anything that isn't an N64 ROM.
+--------------------------------------------------------*/
+static u32 _getFourCC( const u32 magic )
+{
+  return (((magic == 0x80371240U) << 3) |
+          ((magic == 0x40123780U) << 2) |
+          ((magic == 0x37804012U) << 1) |
+           (magic == 0x12408037U));
+}
+
+
+
+static u32 _getSwizzle( const u32 fourCC )
+{
+  switch ( fourCC )
+  {
+    case 4:  return 3U;
+    case 2:  return 1U;
+    case 1:  return 2U;
+    default: return 0;
+  }
+}
+
+
+
+/*------------------------------------------------------------------
+The path of the Big-Endian ROM written by "-o"; "newPathROM" has room
+for "PPATH_MAX" + 8 characters.
+------------------------------------------------------------------*/
+static void _getBSPath( const char *pathROM, char *newPathROM )
 {
-  FILE *ROM = (FILE *)0;
-  char newPathROM[PPATH_MAX + 8];
   register unsigned i = 0;
 
   i = (unsigned)strlen( strcpy( newPathROM, pathROM ) );
@@ -1244,6 +11155,19 @@ static int _writeROM( const u8 *srcbuf, const u32 lengthROM,
   }
   while ( 1 );
 
+  return;
+}
+
+
+
+static int _writeROM( const u8 *srcbuf, const u32 lengthROM,
+                      const char *pathROM )
+{
+  FILE *ROM = (FILE *)0;
+  char newPathROM[PPATH_MAX + 8];
+
+  _getBSPath( pathROM, newPathROM );
+
   if ( (ROM = fopen( newPathROM, "wb" )) == (FILE *)0 )
   {
     return EXIT_FAILURE;
@@ -1251,6 +11175,7 @@ static int _writeROM( const u8 *srcbuf, const u32 lengthROM,
   else
   {
     fwrite( srcbuf, sizeof(u8), lengthROM, ROM );
+    METER_ADD( written, lengthROM );
     srcbuf -= lengthROM;
     fflush( ROM );
     fclose( ROM );